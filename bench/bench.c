@@ -0,0 +1,191 @@
+#include "gb.h"
+#include "instructions.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROM_SIZE 0x8000
+
+/**
+Built-in workload, placed at 0x0150 behind the usual "nop; jp 0150" entry point.
+
+0150    ld sp, FFFE
+0153    ld hl, C000     outer
+0156    ld b, 40
+0158    ld a, (hl+)     inner
+0159    add a, b
+015A    ld (hl), a
+015B    call 0170
+015E    dec b
+015F    jr nz, inner
+0161    jp outer
+0170    push bc
+0171    inc a
+0172    cp 10
+0174    pop bc
+0175    ret
+*/
+static const uint8_t bench_entry[] = {0x00, 0xC3, 0x50, 0x01};
+static const uint8_t bench_main[] = {
+    0x31, 0xFE, 0xFF,
+    0x21, 0x00, 0xC0,
+    0x06, 0x40,
+    0x2A,
+    0x80,
+    0x77,
+    0xCD, 0x70, 0x01,
+    0x05,
+    0x20, 0xF7,
+    0xC3, 0x53, 0x01,
+};
+static const uint8_t bench_sub[] = {0xC5, 0x3C, 0xFE, 0x10, 0xC1, 0xC9};
+
+typedef struct {
+    const char *name;
+    void (*run)(gb_instance *gb);
+} bench_engine;
+
+#ifdef GB_HAVE_JIT
+static void run_jit(gb_instance *gb) {
+    jit_set_mode(gb, JIT_ON);
+    jit_run(gb);
+}
+#endif
+
+static const bench_engine engines[] = {
+    {"table", instructions_run_table},
+    {"switch", instructions_run_switch},
+#ifdef GB_HAVE_COMPUTED_GOTO
+    {"goto", instructions_run_goto},
+#endif
+#ifdef GB_HAVE_JIT
+    {"jit", run_jit},
+#endif
+};
+
+static uint8_t *bench_rom(uint32_t *rom_size) {
+    uint8_t *rom = (uint8_t *)calloc(BENCH_ROM_SIZE, sizeof(uint8_t));
+
+    memcpy(rom + 0x0100, bench_entry, sizeof(bench_entry));
+    memcpy(rom + 0x0134, "DISPATCH BENCH", 14);
+    memcpy(rom + 0x0150, bench_main, sizeof(bench_main));
+    memcpy(rom + 0x0170, bench_sub, sizeof(bench_sub));
+
+    *rom_size = BENCH_ROM_SIZE;
+    return rom;
+}
+
+static uint8_t *load_rom(const char *path, uint32_t *rom_size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    *rom_size = (uint32_t)ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *rom = (uint8_t *)malloc(*rom_size);
+    if (rom != NULL && fread(rom, 1, *rom_size, fp) != *rom_size) {
+        free(rom);
+        rom = NULL;
+    }
+
+    fclose(fp);
+    return rom;
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// single-step once through the workload so every engine is measured against the same instruction count
+static uint64_t count_instructions(const uint8_t *rom, uint32_t rom_size, uint64_t cycles) {
+    gb_instance *gb = gb_create_rom(rom, rom_size);
+    uint64_t count = 0;
+
+    // instructions_step never fuses, so this counts guest instructions rather than dispatches
+    while (gb->cpu.cycles < cycles) {
+        instructions_step(gb);
+        count++;
+    }
+
+    gb_destroy(gb);
+    return count;
+}
+
+static double run_engine(const bench_engine *engine, const uint8_t *rom, uint32_t rom_size, uint64_t cycles) {
+    gb_instance *gb = gb_create_rom(rom, rom_size);
+
+    double start = now_seconds();
+    gb->run_deadline = cycles;
+    engine->run(gb);
+    double elapsed = now_seconds() - start;
+
+    gb_destroy(gb);
+    return elapsed;
+}
+
+#ifdef GB_HAVE_JIT
+// replay every recompiled block on the interpreter and count disagreements
+static void verify_jit(const uint8_t *rom, uint32_t rom_size, uint64_t cycles) {
+    gb_instance *gb = gb_create_rom(rom, rom_size);
+
+    jit_set_mode(gb, JIT_VERIFY);
+    gb->run_deadline = cycles;
+    jit_run(gb);
+
+    const jit_stats *stats = jit_get_stats(gb);
+    printf("\njit verify: %llu blocks compiled, %llu runs checked, %llu mismatches\n",
+           (unsigned long long)stats->blocks_compiled, (unsigned long long)stats->verified,
+           (unsigned long long)stats->mismatches);
+    if (stats->mismatches != 0) {
+        printf("last mismatch in block %04X-%04X\n", stats->mismatch_start, stats->mismatch_end);
+    }
+
+    gb_destroy(gb);
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    // usage: gb_bench [frames] [rom], the built-in workload is used without a rom
+    uint32_t frames = argc > 1 ? (uint32_t)atoi(argv[1]) : 600;
+    const char *rom_path = argc > 2 ? argv[2] : NULL;
+    uint64_t cycles = (uint64_t)frames * GB_CYCLES_PER_FRAME;
+
+    uint32_t rom_size = 0;
+    uint8_t *rom = rom_path ? load_rom(rom_path, &rom_size) : bench_rom(&rom_size);
+    if (rom == NULL) {
+        printf("rom load fail!\n");
+        return 1;
+    }
+
+    uint64_t instructions = count_instructions(rom, rom_size, cycles);
+
+    printf("\n%u frames, %llu cycles, %llu instructions\n", frames,
+           (unsigned long long)cycles, (unsigned long long)instructions);
+    printf("%-8s %12s %12s %10s\n", "engine", "seconds", "MIPS", "speedup");
+
+    // speedup is relative to the plain table interpreter
+    double baseline = 0;
+    for (size_t i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+        double elapsed = run_engine(&engines[i], rom, rom_size, cycles);
+        if (i == 0) {
+            baseline = elapsed;
+        }
+        printf("%-8s %12.4f %12.2f %9.2fx\n", engines[i].name, elapsed,
+               (double)instructions / elapsed / 1e6, baseline / elapsed);
+    }
+
+#ifdef GB_HAVE_JIT
+    verify_jit(rom, rom_size, cycles);
+#endif
+
+    free(rom);
+    return 0;
+}
@@ -2,10 +2,84 @@
 #define __BUS_H
 
 #include <stdint.h>
+#include <string.h>
 
-void mem_init();
+#define VRAM_BANKS 2 // CGB, a DMG only sees bank 0
+#define WRAM_BANKS 8 // CGB, a DMG only sees banks 0 and 1
+#define VRAM_BANK_SIZE 0x2000
+#define WRAM_BANK_SIZE 0x1000
 
-uint8_t bus_read(uint16_t addr);
-void bus_write(uint16_t addr, uint8_t data);
+/**
+ * VRAM is one switchable 8kB bank (VBK), WRAM is a fixed 4kB bank at C000
+ * and a switchable one at D000 (SVBK). Switching only re-points the bus map
+ * entries, the banks themselves never move.
+ */
+typedef struct {
+    uint8_t vram[VRAM_BANKS][VRAM_BANK_SIZE];
+    uint8_t wram[WRAM_BANKS][WRAM_BANK_SIZE];
+    uint8_t oam[160];
+    uint8_t hram[128];
+    uint8_t vram_bank; // mapped at 8000-9FFF
+    uint8_t wram_bank; // mapped at D000-DFFF, 1-7
+} emu_bus;
+
+// host byte behind 8000-9FFF in the current bank
+static inline uint8_t *bus_vram(emu_bus *bus, uint16_t addr) {
+    return &bus->vram[bus->vram_bank][addr - 0x8000];
+}
+
+// host byte behind C000-DFFF in the current bank
+static inline uint8_t *bus_wram(emu_bus *bus, uint16_t addr) {
+    return addr < 0xD000 ? &bus->wram[0][addr - 0xC000] : &bus->wram[bus->wram_bank][addr - 0xD000];
+}
+
+/**
+ * Memory map, one entry per 256-byte page. An entry points at the host bytes
+ * behind the page, so a plain ROM or RAM access is one indexed load or store.
+ * NULL entries go to the handlers in bus.c: I/O and HRAM, cartridge RAM and
+ * mapper registers, and WRAM pages holding decoded code, whose writes have to
+ * invalidate it. Bank switches re-point entries, see bus_map_rom_bank.
+ */
+typedef struct {
+    uint8_t *read[256];
+    uint8_t *write[256];
+} bus_map;
+
+struct gb_instance;
+
+void mem_init(struct gb_instance *gb);
+// rebuild the whole table from the current banks and watched pages
+void bus_map_reset(struct gb_instance *gb);
+void bus_map_rom_bank(struct gb_instance *gb);
+// send every access to start-end through the handlers until the next bus_map_reset
+void bus_unmap(struct gb_instance *gb, uint16_t start, uint16_t end);
+// VBK / SVBK, O(1): only the map entries of the window move
+void bus_set_vram_bank(struct gb_instance *gb, uint8_t bank);
+void bus_set_wram_bank(struct gb_instance *gb, uint8_t bank);
+// route writes to the WRAM page holding addr through the handlers
+void bus_watch_writes(struct gb_instance *gb, uint16_t addr);
+
+uint8_t bus_read(struct gb_instance *gb, uint16_t addr);
+void bus_write(struct gb_instance *gb, uint16_t addr, uint8_t data);
+
+// little-endian 16-bit value at p, which need not be aligned
+static inline uint16_t bus_load16(const uint8_t *p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+#else
+    return (uint16_t)(p[0] | p[1] << 8);
+#endif
+}
+
+static inline void bus_store16(uint8_t *p, uint16_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(p, &v, sizeof(v));
+#else
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+#endif
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef __CALLSTACK_H
+#define __CALLSTACK_H
+
+/**
+ * Guest call-stack profiler, part of the GB_PROFILE build. CALL, RST and
+ * interrupt entry push a shadow frame, RET and RETI pop back to the frame
+ * whose return address they take. The emulated cycles between two such
+ * transitions go to the call path that was current, and the call tree is
+ * exported in the folded-stack format flamegraph.pl and speedscope read.
+ * Returns that match no frame (a RET used as a computed jump) are ignored.
+ * JIT_VERIFY replays every block, so it records each call twice.
+ */
+#ifdef GB_PROFILE
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define CALLSTACK_MAX_DEPTH 128
+
+typedef enum {
+    CALLSTACK_CALL, // CALL and RST
+    CALLSTACK_IRQ,  // interrupt dispatch
+} callstack_kind;
+
+typedef struct {
+    uint32_t key;         // kind << 28 | RAM flag << 27 | bank << 16 | address, see callstack_key
+    uint32_t parent;
+    uint32_t first_child; // 0 is the root, so it also means none
+    uint32_t next_sibling;
+    uint64_t cycles;      // spent in this routine itself
+} callstack_node;
+
+typedef struct {
+    uint32_t caller;      // node current before the call
+    uint16_t sp;          // where the return address was pushed
+} callstack_frame;
+
+typedef struct {
+    callstack_node *nodes; // NULL while the profiler is off, nodes[0] is the root
+    uint32_t node_count;
+    uint32_t node_capacity;
+    uint32_t current;
+    uint64_t last_cycles;  // when current was entered or last charged
+    callstack_frame frames[CALLSTACK_MAX_DEPTH];
+    uint32_t depth;
+    uint64_t overflows;    // calls not tracked because the stack was full
+    uint64_t unmatched;    // returns that matched no frame
+} callstack_data;
+
+struct gb_instance;
+
+void callstack_start(struct gb_instance *gb);
+void callstack_stop(struct gb_instance *gb);
+void callstack_enter(struct gb_instance *gb, uint16_t target, callstack_kind kind);
+// sp is where the return address was read from
+void callstack_leave(struct gb_instance *gb, uint16_t sp);
+// one line per call path: frames separated by ';', then the cycles spent there
+int callstack_write_folded(struct gb_instance *gb, FILE *out);
+
+#define CALLSTACK_ENTER(gb, target, kind)                   \
+    do {                                                    \
+        if ((gb)->callstack.nodes != NULL) {                \
+            callstack_enter((gb), (target), (kind));        \
+        }                                                   \
+    } while (0)
+
+#define CALLSTACK_LEAVE(gb, sp)                             \
+    do {                                                    \
+        if ((gb)->callstack.nodes != NULL) {                \
+            callstack_leave((gb), (sp));                    \
+        }                                                   \
+    } while (0)
+#else
+#define CALLSTACK_ENTER(gb, target, kind) ((void)0)
+#define CALLSTACK_LEAVE(gb, sp) ((void)0)
+#endif
+
+#endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef __CART_H
 #define __CART_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef struct {
@@ -19,6 +20,12 @@ typedef struct {
     uint8_t global_checksum[2];
 } cart_header;
 
+typedef struct {
+    uint8_t *rom_data;
+    uint32_t rom_size;
+    uint16_t rom_bank; // bank mapped at 4000-7FFF
+} emu_cart;
+
 static const char *ROM_TYPES[] = {
     "ROM ONLY",
     "MBC1",
@@ -66,8 +73,15 @@ static const char *RAM_SIZE_TYPES[] = {
     "64 KB (8 banks of 8KB each)"
 };
 
-void cart_init(const char *cart_path);
-uint8_t cart_mem_read(uint16_t addr);
-void cart_mem_write(uint16_t addr, uint8_t data);
+struct gb_instance;
+
+int cart_init(struct gb_instance *gb, const char *cart_path);
+int cart_init_rom(struct gb_instance *gb, const uint8_t *rom_data, uint32_t rom_size);
+void cart_free(struct gb_instance *gb);
+// title, mapper, RAM size and licensee to stdout; the core never prints it on its own
+void cart_print_header(struct gb_instance *gb);
+bool cart_cgb(struct gb_instance *gb);
+uint8_t cart_mem_read(struct gb_instance *gb, uint16_t addr);
+void cart_mem_write(struct gb_instance *gb, uint16_t addr, uint8_t data);
 
 #endif
\ No newline at end of file
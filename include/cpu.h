@@ -4,44 +4,209 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/**
+ * Each pair is a union of its two 8-bit halves and the 16-bit value, with
+ * the halves ordered for the host so reg.hl and reg.h/reg.l alias the
+ * same bytes and no shifting is needed either way.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define REG_PAIR(hi, lo) union { struct { uint8_t hi, lo; }; uint16_t hi##lo; }
+#else
+#define REG_PAIR(hi, lo) union { struct { uint8_t lo, hi; }; uint16_t hi##lo; }
+#endif
+
 typedef struct {
-    uint8_t a, f;
-    uint8_t b, c;
-    uint8_t d, e;
-    uint8_t h, l;
+    REG_PAIR(a, f);
+    REG_PAIR(b, c);
+    REG_PAIR(d, e);
+    REG_PAIR(h, l);
     uint16_t sp, pc;
 } cpu_register;
 
+/**
+ * Lazy flags (GB_LAZY_FLAGS): ALU ops only store the raw bits each flag is
+ * derived from, and Z/N/H/C are worked out when something reads them. In
+ * this mode reg.f is not kept up to date, use flags_pack() instead.
+ */
+typedef struct {
+    uint8_t z;  // Z is set when this is 0
+    uint8_t n;  // N as 0/1
+    uint16_t h; // H is bit 4 (a ^ b ^ result)
+    uint16_t c; // C is bit 8 (unwrapped result)
+} lazy_flags;
+
 typedef struct {
     cpu_register reg;
+#ifdef GB_LAZY_FLAGS
+    lazy_flags flags;
+#endif
     uint8_t opcode;
-    uint32_t cycles;
+    uint16_t imm; // immediate operand of the current instruction, filled in at fetch
+    uint16_t imm_fused; // immediates of the rest of a fused sequence, see decode_fused
+    uint64_t cycles;
     bool halted;
 } emu_cpu;
 
-uint16_t get_AF();
-uint16_t get_BC();
-uint16_t get_DE();
-uint16_t get_HL();
-
-void set_AF(uint16_t v);
-void set_BC(uint16_t v);
-void set_DE(uint16_t v);
-void set_HL(uint16_t v);
-
-uint8_t flag_Z();
-uint8_t flag_N();
-uint8_t flag_H();
-uint8_t flag_C();
-
-void set_Z(uint8_t v);
-void set_N(uint8_t v);
-void set_H(uint8_t v);
-void set_C(uint8_t v);
-
-void cpu_init();
-void cpu_step();
-void enable_interrupt();
-void print_reg();
+struct gb_instance;
+
+void cpu_init(struct gb_instance *gb);
+void cpu_step(struct gb_instance *gb);
+void enable_interrupt(struct gb_instance *gb);
+void print_reg(struct gb_instance *gb);
+
+#ifdef GB_LAZY_FLAGS
+
+static inline uint8_t flag_Z(emu_cpu *cpu) {
+    return cpu->flags.z == 0;
+}
+
+static inline uint8_t flag_N(emu_cpu *cpu) {
+    return cpu->flags.n;
+}
+
+static inline uint8_t flag_H(emu_cpu *cpu) {
+    return (cpu->flags.h >> 4) & 1;
+}
+
+static inline uint8_t flag_C(emu_cpu *cpu) {
+    return (cpu->flags.c >> 8) & 1;
+}
+
+static inline void set_Z(emu_cpu *cpu, uint8_t v) {
+    cpu->flags.z = !v;
+}
+
+static inline void set_N(emu_cpu *cpu, uint8_t v) {
+    cpu->flags.n = v & 1;
+}
+
+static inline void set_H(emu_cpu *cpu, uint8_t v) {
+    cpu->flags.h = (uint16_t)(v & 1) << 4;
+}
+
+static inline void set_C(emu_cpu *cpu, uint8_t v) {
+    cpu->flags.c = (uint16_t)(v & 1) << 8;
+}
+
+// Raw flag sources: Z is set when z is 0, N is n, H is bit 4 of h, C is bit 8 of c.
+static inline void flags_znhc(emu_cpu *cpu, uint8_t z, uint8_t n, uint16_t h, uint16_t c) {
+    cpu->flags.z = z;
+    cpu->flags.n = n;
+    cpu->flags.h = h;
+    cpu->flags.c = c;
+}
+
+static inline void flags_znh(emu_cpu *cpu, uint8_t z, uint8_t n, uint16_t h) {
+    cpu->flags.z = z;
+    cpu->flags.n = n;
+    cpu->flags.h = h;
+}
+
+static inline void flags_nhc(emu_cpu *cpu, uint8_t n, uint16_t h, uint16_t c) {
+    cpu->flags.n = n;
+    cpu->flags.h = h;
+    cpu->flags.c = c;
+}
+
+static inline uint8_t flags_pack(emu_cpu *cpu) {
+    return (uint8_t)(flag_Z(cpu) << 7 | flag_N(cpu) << 6 | flag_H(cpu) << 5 | flag_C(cpu) << 4);
+}
+
+static inline void flags_unpack(emu_cpu *cpu, uint8_t f) {
+    cpu->flags.z = !(f & 0x80);
+    cpu->flags.n = (f >> 6) & 1;
+    cpu->flags.h = (f >> 1) & 0x10;
+    cpu->flags.c = (uint16_t)(f & 0x10) << 4;
+}
+
+#else
+
+static inline uint8_t flag_Z(emu_cpu *cpu) {
+    return !!(cpu->reg.f & 0x80);
+}
+
+static inline uint8_t flag_N(emu_cpu *cpu) {
+    return !!(cpu->reg.f & 0x40);
+}
+
+static inline uint8_t flag_H(emu_cpu *cpu) {
+    return !!(cpu->reg.f & 0x20);
+}
+
+static inline uint8_t flag_C(emu_cpu *cpu) {
+    return !!(cpu->reg.f & 0x10);
+}
+
+static inline void set_Z(emu_cpu *cpu, uint8_t v) {
+    cpu->reg.f = ((cpu->reg.f & 0x7F) | (v & 1) << 7);
+}
+
+static inline void set_N(emu_cpu *cpu, uint8_t v) {
+    cpu->reg.f = ((cpu->reg.f & 0xBF) | (v & 1) << 6);
+}
+
+static inline void set_H(emu_cpu *cpu, uint8_t v) {
+    cpu->reg.f = ((cpu->reg.f & 0xDF) | (v & 1) << 5);
+}
+
+static inline void set_C(emu_cpu *cpu, uint8_t v) {
+    cpu->reg.f = ((cpu->reg.f & 0xEF) | (v & 1) << 4);
+}
+
+static inline void flags_znhc(emu_cpu *cpu, uint8_t z, uint8_t n, uint16_t h, uint16_t c) {
+    cpu->reg.f = (uint8_t)((z == 0) << 7 | (n & 1) << 6 | (h & 0x10) << 1 | ((c >> 4) & 0x10));
+}
+
+static inline void flags_znh(emu_cpu *cpu, uint8_t z, uint8_t n, uint16_t h) {
+    cpu->reg.f = (uint8_t)((z == 0) << 7 | (n & 1) << 6 | (h & 0x10) << 1 | (cpu->reg.f & 0x10));
+}
+
+static inline void flags_nhc(emu_cpu *cpu, uint8_t n, uint16_t h, uint16_t c) {
+    cpu->reg.f = (uint8_t)((cpu->reg.f & 0x80) | (n & 1) << 6 | (h & 0x10) << 1 | ((c >> 4) & 0x10));
+}
+
+static inline uint8_t flags_pack(emu_cpu *cpu) {
+    return cpu->reg.f;
+}
+
+static inline void flags_unpack(emu_cpu *cpu, uint8_t f) {
+    cpu->reg.f = f & 0xF0;
+}
+
+#endif
+
+// F lives in the flag state rather than reg.f, so AF goes through pack/unpack
+static inline uint16_t get_AF(emu_cpu *cpu) {
+    return ((uint16_t)cpu->reg.a << 8) | flags_pack(cpu);
+}
+
+static inline void set_AF(emu_cpu *cpu, uint16_t v) {
+    cpu->reg.a = v >> 8;
+    flags_unpack(cpu, v & 0xF0);
+}
+
+static inline uint16_t get_BC(emu_cpu *cpu) {
+    return cpu->reg.bc;
+}
+
+static inline uint16_t get_DE(emu_cpu *cpu) {
+    return cpu->reg.de;
+}
+
+static inline uint16_t get_HL(emu_cpu *cpu) {
+    return cpu->reg.hl;
+}
+
+static inline void set_BC(emu_cpu *cpu, uint16_t v) {
+    cpu->reg.bc = v;
+}
+
+static inline void set_DE(emu_cpu *cpu, uint16_t v) {
+    cpu->reg.de = v;
+}
+
+static inline void set_HL(emu_cpu *cpu, uint16_t v) {
+    cpu->reg.hl = v;
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef __DECODE_H
+#define __DECODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DECODE_ROM_BANKS 512
+#define DECODE_BANK_SIZE 0x4000
+#define DECODE_WRAM_SIZE 0x2000
+#define DECODE_HRAM_SIZE 0x80
+
+/**
+ * One pre-decoded instruction. Immediates are pulled out at decode time,
+ * so executing a cached instruction needs no bus access beyond its own
+ * memory operands.
+ */
+typedef struct {
+    uint16_t operand; // d8/a8/r8 in the low byte, or the whole d16/a16
+    uint8_t opcode;   // index into instruction_set
+    uint8_t length;   // 0 while the entry has not been decoded yet
+    uint8_t cycles;   // base cycles, branches not taken
+    uint8_t fused;    // decode_fused id when this instruction starts a known idiom
+    uint16_t fused_operand; // immediates of the instructions after the first one
+} decoded_instruction;
+
+/**
+ * Superinstructions: short ROM idioms the fast interpreter engines run as
+ * one handler. The entry above still describes the first instruction on its
+ * own, so single-stepping, the precise build, the JIT and gb_staticrec never
+ * see a fusion.
+ */
+typedef enum {
+    FUSED_NONE,
+    FUSED_LDI_A_MHL_LD_MDE_A, // ld a,(hl+); ld (de),a
+    FUSED_COPY_HLI_TO_DE,     // ld a,(hl+); ld (de),a; inc de
+    FUSED_COPY_DE_TO_HLI,     // ld a,(de); ld (hl+),a; inc de
+    FUSED_DEC_B_JR_NZ,        // dec r; jr nz,r8
+    FUSED_DEC_C_JR_NZ,
+    FUSED_DEC_D_JR_NZ,
+    FUSED_DEC_E_JR_NZ,
+    FUSED_DEC_A_JR_NZ,
+    FUSED_DEC_BC_JR_NZ,       // dec bc; ld a,b; or c; jr nz,r8
+    FUSED_LDH_CP_JR_NZ,       // ldh a,(a8); cp d8; jr nz,r8
+    FUSED_LDH_CP_JR_Z,        // ldh a,(a8); cp d8; jr z,r8
+    FUSED_IDLE_LOOP,          // a loop polling memory without side effects, see idle.h
+    FUSED_COUNT,
+} decode_fused;
+
+/**
+ * Decode cache, keyed by (ROM bank, address). ROM banks are decoded on
+ * first use and never invalidated. WRAM and HRAM can hold code too, so
+ * bus writes there drop the entries that may cover the written byte.
+ */
+typedef struct {
+    decoded_instruction *rom[DECODE_ROM_BANKS];
+    decoded_instruction *wram;
+    decoded_instruction hram[DECODE_HRAM_SIZE];
+    decoded_instruction scratch;      // for code running outside the cached regions
+    uint8_t wram_pages[DECODE_WRAM_SIZE >> 8]; // 1 when the 256-byte page has decoded entries
+    uint8_t hram_decoded;
+} decode_cache;
+
+// how an instruction leaves its basic block, for the recompilers
+typedef enum {
+    FLOW_NEXT,        // falls through to the next instruction
+    FLOW_JUMP,        // JP a16, JR r8: one fixed target
+    FLOW_CALL,        // CALL a16, RST: fixed target, returns to the next instruction
+    FLOW_BRANCH,      // JR cc, JP cc, CALL cc: fixed target or the next instruction
+    FLOW_RETURN,      // RET, RETI, JP HL: target only known at run time
+    FLOW_RETURN_COND, // RET cc: run-time target or the next instruction
+    FLOW_STOP,        // HALT, STOP, DI, EI: resumes at the next instruction, but not straight away
+    FLOW_ILLEGAL,
+} decode_flow;
+
+struct gb_instance;
+
+extern const uint8_t instruction_length[256];
+extern const uint8_t instruction_cycles[256];
+
+void decode_init(struct gb_instance *gb);
+void decode_free(struct gb_instance *gb);
+// WRAM/HRAM entries, their page watches and the JIT blocks on them are kept
+void decode_drop_rom(struct gb_instance *gb);
+
+decoded_instruction *decode_fill(struct gb_instance *gb, uint16_t pc, decoded_instruction *entry);
+decode_flow decode_flow_of(const decoded_instruction *entry, uint16_t pc, uint16_t *target);
+uint8_t decode_taken_cycles(uint8_t opcode);
+bool decode_writes_memory(uint8_t opcode, uint8_t cb);
+void decode_reject_idle(struct gb_instance *gb, uint16_t pc);
+void decode_invalidate_wram(struct gb_instance *gb, uint16_t addr);
+bool decode_invalidate_wram_bank(struct gb_instance *gb);
+void decode_invalidate_hram(struct gb_instance *gb, uint16_t addr);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef __DMA_H
+#define __DMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OAM_DMA_LENGTH 160 // bytes, one per M-cycle
+#define HDMA_BLOCK 16       // bytes
+#define HDMA_BLOCK_CYCLES 8 // M-cycles the CPU is stopped for per block, single speed
+
+/**
+ * OAM DMA, started by a write to FF46. Under GB_ACCURACY_FAST the 160 bytes
+ * are copied in one go when the register is written. Under
+ * GB_ACCURACY_PRECISE the transfer starts one M-cycle after the write and
+ * moves a byte per M-cycle on SCHED_OAM_DMA. While it runs the CPU cannot
+ * use OAM or the bus the source sits on (external: ROM, cart RAM and WRAM,
+ * or video: VRAM): those pages are taken out of the bus map, reads there
+ * return the byte being moved and writes are dropped. HRAM and I/O stay
+ * reachable.
+ */
+typedef struct {
+    bool active;     // bytes are moving, the CPU is locked out (precise only)
+    uint16_t source; // XX00
+    uint8_t index;   // next byte to move
+    uint8_t value;   // last byte moved, what a conflicting read sees
+    uint64_t start;  // cycle the first byte moves on
+} oam_dma_state;
+
+/**
+ * CGB VRAM DMA, HDMA1-4 (FF51-FF54) hold the source and destination and
+ * HDMA5 (FF55) starts a transfer of (n & 0x7F) + 1 blocks. General-purpose
+ * DMA (bit 7 clear) copies everything at once and stops the CPU for the
+ * whole transfer. HBlank DMA (bit 7 set) moves one block per HBlank, each a
+ * SCHED_HDMA event, and is cancelled by a write with bit 7 clear. There is
+ * no PPU yet, so HBlank is taken from the fixed line timing: 114 M-cycles a
+ * line, 144 visible lines, HBlank from M-cycle 63 of the line.
+ */
+typedef struct {
+    bool active;       // an HBlank transfer is armed
+    uint16_t source;   // next source byte
+    uint16_t dest;     // next VRAM byte, 8000-9FF0
+    uint8_t remaining; // blocks still to move
+} hdma_state;
+
+struct gb_instance;
+
+// claims FF46 and SCHED_OAM_DMA, and in CGB mode FF55 and SCHED_HDMA
+void dma_init(struct gb_instance *gb);
+// addr is on the bus the running transfer is using, or in OAM
+bool oam_dma_conflict(struct gb_instance *gb, uint16_t addr);
+// a precise transfer took addr's page (below FE00) out of the bus map, bank switches must leave it there
+bool oam_dma_locks(struct gb_instance *gb, uint16_t addr);
+
+#endif
\ No newline at end of file
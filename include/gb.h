@@ -0,0 +1,147 @@
+#ifndef __GB_H
+#define __GB_H
+
+#include "cpu.h"
+#include "bus.h"
+#include "cart.h"
+#include "decode.h"
+#include "jit.h"
+#include "staticrec.h"
+#include "idle.h"
+#include "sched.h"
+#include "interrupt.h"
+#include "io.h"
+#include "dma.h"
+#include "profile.h"
+#include "hotspot.h"
+#include "callstack.h"
+#include "trace.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 70224 dots per frame, counted in M-cycles like emu_cpu.cycles
+#define GB_CYCLES_PER_FRAME 17556
+
+// timing model of an instance, see gb_set_accuracy
+typedef enum {
+    GB_ACCURACY_FAST,    // cycles are batched per instruction, peripherals catch up between instructions
+    GB_ACCURACY_PRECISE, // peripherals are ticked up to every memory access (M-cycle timing)
+} gb_accuracy;
+
+/**
+ * One emulated Game Boy. Every piece of machine state lives in here, so any
+ * number of instances can run side by side (one per thread, no locking).
+ */
+typedef struct gb_instance {
+    emu_cpu cpu;
+    emu_bus bus;
+    bus_map map;             // page table in front of bus, see bus.h
+    emu_cart cart;
+    bool cgb;                // CGB mode, the cart header asks for it (see cart_cgb)
+    interrupt_ctrl irq;
+    io_ports io;             // FF00-FF7F and IE, see io.h
+    oam_dma_state oam_dma;
+    hdma_state hdma;
+    decode_cache decode;
+    struct jit_state *jit;   // NULL unless jit_set_mode turned the recompiler on
+    const staticrec_image *rec; // ahead-of-time translation of this cart, see staticrec_attach
+    gb_accuracy accuracy;
+
+    uint64_t run_deadline;   // the engine returns once cpu.cycles reaches this, never past next_event
+    uint64_t frame_deadline; // cycle count at which the current frame ends
+    scheduler sched;
+    uint64_t next_event;     // earliest pending sched deadline, UINT64_MAX when nothing is scheduled
+    bool exit_requested;     // set by gb_request_exit, ends gb_run_until after the current instruction
+
+    bool idle_skip;          // fast-forward idle polling loops, on by default (gb_set_idle_skip)
+    idle_stats idle;
+#if GB_TRACE_LEVEL > TRACE_LEVEL_OFF
+    trace_buffer trace;      // see trace.h
+#endif
+#ifdef GB_PROFILE
+    profile_data profile;    // see profile.h
+    hotspot_data hotspot;    // see hotspot.h
+    callstack_data callstack; // see callstack.h
+#endif
+} gb_instance;
+
+// Make the dispatch engine return after the current instruction. Unlike
+// gb_request_exit, gb_run_until carries on towards the same deadline.
+static inline void gb_break_engine(gb_instance *gb) {
+    if (gb->run_deadline > gb->cpu.cycles) {
+        gb->run_deadline = gb->cpu.cycles;
+    }
+}
+
+// A halted CPU has nothing to do before the next event or the end of the run.
+static inline uint64_t gb_wake_cycle(const gb_instance *gb) {
+    uint64_t wake = gb->next_event < gb->run_deadline ? gb->next_event : gb->run_deadline;
+    return wake > gb->cpu.cycles ? wake : gb->cpu.cycles + 1;
+}
+
+/**
+ * 16-bit bus access, low byte at addr. When both bytes sit in one directly
+ * mapped page (ROM, VRAM, WRAM) or in HRAM, it is a single host load or
+ * store. I/O, page-crossing accesses and RAM holding decoded code go
+ * through bus_read/bus_write one byte at a time, low byte first.
+ */
+static inline uint8_t *bus_host16(uint8_t *const *pages, uint16_t addr) {
+    uint8_t *page = pages[addr >> 8];
+
+    if (page == NULL || (addr & 0xFF) == 0xFF) {
+        return NULL;
+    }
+    return page + (addr & 0xFF);
+}
+
+static inline uint16_t bus_read16(gb_instance *gb, uint16_t addr) {
+    const uint8_t *p = bus_host16(gb->map.read, addr);
+
+    if (p != NULL) {
+        return bus_load16(p);
+    }
+    if (addr >= 0xFF80 && addr <= 0xFFFD) {
+        return bus_load16(&gb->bus.hram[addr - 0xFF80]);
+    }
+    uint16_t low = bus_read(gb, addr);
+    return (uint16_t)(low | bus_read(gb, addr + 1) << 8);
+}
+
+static inline void bus_write16(gb_instance *gb, uint16_t addr, uint16_t data) {
+    uint8_t *p = bus_host16(gb->map.write, addr);
+
+    if (p != NULL) {
+        bus_store16(p, data);
+        return ;
+    }
+    if (addr >= 0xFF80 && addr <= 0xFFFD && !gb->decode.hram_decoded) {
+        bus_store16(&gb->bus.hram[addr - 0xFF80], data);
+        return ;
+    }
+    bus_write(gb, addr, (uint8_t)data);
+    bus_write(gb, addr + 1, (uint8_t)(data >> 8));
+}
+
+gb_instance *gb_create(const char *cart_path);
+gb_instance *gb_create_rom(const uint8_t *rom_data, uint32_t rom_size);
+void gb_destroy(gb_instance *gb);
+
+/**
+ * Pick the timing model, meant to be called right after gb_create. Both run
+ * the same handler source. GB_ACCURACY_PRECISE is for test ROMs and runs on
+ * the plain interpreter only: the JIT, static recompilation and idle-loop
+ * skipping are bypassed while it is on.
+ */
+void gb_set_accuracy(gb_instance *gb, gb_accuracy accuracy);
+
+/**
+ * Batch execution. Both calls keep the CPU inside one loop and only hand
+ * control back at the cycle budget, the end of the frame, or when an event
+ * calls gb_request_exit. They return the number of cycles actually run.
+ */
+uint32_t gb_run_cycles(gb_instance *gb, uint32_t cycles);
+uint32_t gb_run_frame(gb_instance *gb);
+void gb_request_exit(gb_instance *gb);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef __HOTSPOT_H
+#define __HOTSPOT_H
+
+/**
+ * Guest PC hotspot sampler and code coverage, part of the GB_PROFILE build.
+ * Every interval M-cycles a scheduler event records the PC together with the
+ * ROM bank it runs in, so sampling costs nothing between samples. The
+ * optional coverage bitmap has one bit per ROM byte (bank, address) and
+ * one per byte of 8000-FFFF. The profiled interpreter sets the bit of every
+ * executed opcode; blocks run by the JIT or the static recompiler mark
+ * nothing, so run with JIT_OFF and without GB_STATICREC when coverage
+ * matters. PC samples are taken under every engine.
+ */
+#ifdef GB_PROFILE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HOTSPOT_RAM_BANK 0xFFFF // bank reported for code outside 0000-7FFF
+
+typedef struct {
+    uint16_t bank;
+    uint16_t addr;
+    uint32_t hits;
+} hotspot_entry;
+
+typedef struct {
+    uint32_t interval;      // M-cycles between samples, 0 while stopped
+    uint64_t samples;
+    uint32_t *keys;         // open addressing, bank << 16 | addr, 0xFFFFFFFF marks a free slot
+    uint32_t *hits;
+    uint32_t capacity;      // power of two
+    uint32_t used;
+    uint8_t *coverage;      // rom_size / 8 bytes indexed by ROM offset, NULL when not requested
+    uint8_t ram_coverage[0x8000 / 8];
+} hotspot_data;
+
+struct gb_instance;
+
+void hotspot_start(struct gb_instance *gb, uint32_t interval, bool coverage);
+void hotspot_stop(struct gb_instance *gb);
+
+// hottest sampled addresses first, returns how many were written to out
+uint32_t hotspot_top(struct gb_instance *gb, hotspot_entry *out, uint32_t max);
+// share of a bank's bytes that started an executed instruction, bank 0 is 0000-3FFF
+double hotspot_bank_coverage(struct gb_instance *gb, uint16_t bank);
+// two CSV tables: the top hot addresses, then coverage per ROM bank
+int hotspot_write_report(struct gb_instance *gb, FILE *out, uint32_t top);
+
+void hotspot_mark(struct gb_instance *gb, uint16_t pc);
+
+#endif
+
+#endif
\ No newline at end of file
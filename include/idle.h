@@ -0,0 +1,26 @@
+#ifndef __IDLE_H
+#define __IDLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Idle-loop skipping. The decoder marks short ROM loops that only read
+ * memory (typically polling LY or a flag an interrupt handler sets) as
+ * FUSED_IDLE_LOOP, so this needs GB_FUSION. When such a loop runs, two
+ * passes are compared. If the second left everything exactly as the first,
+ * nothing can change until the next event, and all the passes before it are
+ * skipped in one step.
+ */
+typedef struct {
+    uint64_t skips;          // times a loop was fast-forwarded
+    uint64_t skipped_cycles; // M-cycles jumped over
+    uint64_t rejected;       // candidates that changed state between passes
+} idle_stats;
+
+struct gb_instance;
+
+void idle_loop_run(struct gb_instance *gb, uint16_t loop, uint16_t end);
+void gb_set_idle_skip(struct gb_instance *gb, bool enable);
+
+#endif
\ No newline at end of file
@@ -2,9 +2,52 @@
 #define __INSTRUCTIONS_H
 
 #include "cpu.h"
+#include "profile.h"
+#include "trace.h"
 
-typedef void (*instruction_func_t)(emu_cpu *cpu);
+struct gb_instance;
+
+typedef void (*instruction_func_t)(struct gb_instance *gb);
 
 extern const instruction_func_t instruction_set[16][16];
+extern const instruction_func_t cb_instruction_set[16][16];
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GB_HAVE_COMPUTED_GOTO
+#endif
+
+// Fetch and execute exactly one instruction, ignoring run_deadline.
+void instructions_step(struct gb_instance *gb);
+
+// Dispatch engines: run instructions until cpu.cycles reaches run_deadline.
+void instructions_run_table(struct gb_instance *gb);
+void instructions_run_switch(struct gb_instance *gb);
+#ifdef GB_HAVE_COMPUTED_GOTO
+void instructions_run_goto(struct gb_instance *gb);
+#endif
+
+// Picked at build time with GB_DISPATCH_TABLE / GB_DISPATCH_SWITCH, computed goto otherwise.
+#if defined(GB_DISPATCH_TABLE)
+#define instructions_run instructions_run_table
+#elif defined(GB_DISPATCH_SWITCH) || !defined(GB_HAVE_COMPUTED_GOTO)
+#define instructions_run instructions_run_switch
+#else
+#define instructions_run instructions_run_goto
+#endif
+
+// Profiled and instruction-traced builds see every instruction, see profile.h and trace.h.
+#ifdef GB_PROFILE
+extern const char *const instruction_names[PROFILE_OPCODES];
+#endif
+#if defined(GB_PROFILE) || GB_TRACE_LEVEL >= TRACE_LEVEL_INSTR
+void instructions_run_instrumented(struct gb_instance *gb);
+#undef instructions_run
+#define instructions_run instructions_run_instrumented
+#endif
+
+// Same handlers with every memory access timed to its M-cycle, see gb_set_accuracy.
+extern const instruction_func_t instruction_set_precise[16][16];
+void instructions_step_precise(struct gb_instance *gb);
+void instructions_run_precise(struct gb_instance *gb);
 
 #endif
\ No newline at end of file
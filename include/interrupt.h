@@ -0,0 +1,50 @@
+#ifndef __INTERRUPT_H
+#define __INTERRUPT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// IE / IF bits, lowest bit has the highest priority
+#define INT_VBLANK 0x01
+#define INT_STAT   0x02
+#define INT_TIMER  0x04
+#define INT_SERIAL 0x08
+#define INT_JOYPAD 0x10
+#define INT_MASK   0x1F
+
+// work left for gb_run_until between two engine runs
+#define IRQ_DEFER_EI       0x01 // EI ran, IME goes up after the next instruction
+#define IRQ_DEFER_HALT_BUG 0x02 // HALT with IME=0 and an interrupt pending, next opcode byte is read twice
+
+/**
+ * Interrupt controller. IE, IF and IME only change on a handful of writes,
+ * so active and pending are recomputed there and nothing is polled per
+ * instruction. When pending goes up the engine is broken out of (the same
+ * way an event does it) and gb_run_until dispatches the interrupt.
+ */
+typedef struct {
+    uint8_t ie;       // FFFF
+    uint8_t flags;    // FF0F, low 5 bits
+    bool ime;
+    uint8_t deferred; // IRQ_DEFER_*
+    uint8_t active;   // ie & flags & INT_MASK, wakes a halted CPU
+    bool pending;     // ime && active, an interrupt is taken before the next instruction
+} interrupt_ctrl;
+
+struct gb_instance;
+
+void interrupt_init(struct gb_instance *gb);
+void interrupt_update(struct gb_instance *gb);
+void interrupt_request(struct gb_instance *gb, uint8_t mask);
+
+// opcode side, called from the EI / DI / HALT / RETI handlers
+void interrupt_ei(struct gb_instance *gb);
+void interrupt_di(struct gb_instance *gb);
+void interrupt_halt(struct gb_instance *gb);
+void interrupt_set_ime(struct gb_instance *gb, bool ime);
+
+// run loop side
+void interrupt_service(struct gb_instance *gb);
+void interrupt_deferred_step(struct gb_instance *gb);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef __IO_H
+#define __IO_H
+
+#include <stdint.h>
+
+#define IO_REGISTERS 0x81 // FF00-FF7F, then IE (FFFF) at 0x80
+
+struct gb_instance;
+
+typedef uint8_t (*io_read_callback)(struct gb_instance *gb, uint16_t addr);
+// data is the register's new value, already merged under its write mask
+typedef void (*io_write_callback)(struct gb_instance *gb, uint16_t addr, uint8_t data);
+
+/**
+ * I/O registers FF00-FF7F and IE. Every register has a backing byte and two
+ * masks: bits in read_mask always read as 1 (unused bits, write-only bits),
+ * and only bits in write_mask change on a CPU write (the rest are read-only
+ * or do not exist). Registers nobody owns are served straight from value[]
+ * without a call. A peripheral that has to see an access installs callbacks
+ * for its registers with io_set_handler, the way it sets its sched handler.
+ */
+typedef struct {
+    uint8_t value[IO_REGISTERS];
+    uint8_t read_mask[IO_REGISTERS];
+    uint8_t write_mask[IO_REGISTERS];
+    io_read_callback read[IO_REGISTERS];   // NULL: read value[]
+    io_write_callback write[IO_REGISTERS]; // NULL: the write only updates value[]
+} io_ports;
+
+static inline uint8_t io_index(uint16_t addr) {
+    return addr == 0xFFFF ? 0x80 : (uint8_t)(addr & 0x7F);
+}
+
+// register masks and the values the boot rom leaves behind (DMG, plus the CGB ones in CGB mode), no handlers
+void io_init(struct gb_instance *gb);
+void io_set_handler(struct gb_instance *gb, uint16_t addr, io_read_callback read, io_write_callback write);
+
+// addr is FF00-FF7F or FFFF
+uint8_t io_read(struct gb_instance *gb, uint16_t addr);
+void io_write(struct gb_instance *gb, uint16_t addr, uint8_t data);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef __JIT_H
+#define __JIT_H
+
+#include <stdint.h>
+
+// the recompiler emits x86-64 machine code, other hosts always interpret
+#if defined(GB_JIT) && defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define GB_HAVE_JIT
+#endif
+
+typedef enum {
+    JIT_OFF,
+    JIT_ON,
+    JIT_VERIFY, // run every block natively, then replay it on the interpreter and compare
+} jit_mode;
+
+typedef struct {
+    uint64_t blocks_compiled;
+    uint64_t flushes;       // code buffer or block pool filled up and was thrown away
+    uint64_t invalidated;   // RAM blocks dropped because their bytes were written
+    uint64_t interpreted;   // instructions run on the interpreter: no block could be built, or it did not fit before run_deadline
+    uint64_t verified;      // blocks checked in JIT_VERIFY mode
+    uint64_t mismatches;    // ... and how many of them disagreed with the interpreter
+    uint16_t mismatch_start; // guest bytes of the last block that disagreed, start-end (exclusive)
+    uint16_t mismatch_end;
+} jit_stats;
+
+struct gb_instance;
+struct jit_state;
+
+int jit_set_mode(struct gb_instance *gb, jit_mode mode);
+void jit_free(struct gb_instance *gb);
+void jit_run(struct gb_instance *gb);
+void jit_invalidate(struct gb_instance *gb, uint16_t addr);
+// drop the RAM blocks overlapping first-last, both included
+void jit_invalidate_range(struct gb_instance *gb, uint16_t first, uint16_t last);
+const jit_stats *jit_get_stats(struct gb_instance *gb);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+/**
+ * Per-opcode execution profiler, built with -DGB_PROFILE=ON. It counts
+ * executions and emulated M-cycles for every opcode, the CB-prefixed ones
+ * included, and samples the host time spent in each opcode class.
+ *
+ * Only the interpreter engines (instructions_run) and cpu_step are counted.
+ * A profiled build dispatches one real opcode at a time, so superinstructions
+ * and idle-loop skipping are off, and the JIT or static recompiler should be
+ * left off too. Without GB_PROFILE none of this is compiled.
+ */
+#ifdef GB_PROFILE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define PROFILE_OPCODES 512     // 0x000-0x0FF main table, 0x100-0x1FF CB table
+#define PROFILE_SAMPLE_MASK 255 // host time is taken for 1 instruction in 256
+
+typedef enum {
+    PROFILE_CLASS_LD8,     // 8-bit loads, LDH, LD (a16)
+    PROFILE_CLASS_LD16,    // 16-bit loads, LD (a16),SP, LD HL,SP+r8
+    PROFILE_CLASS_ALU8,    // 8-bit arithmetic, INC/DEC r, rotates on A, DAA/CPL/SCF/CCF
+    PROFILE_CLASS_ALU16,   // INC/DEC rr, ADD HL,rr, ADD SP,r8
+    PROFILE_CLASS_BRANCH,  // JR, JP, CALL, RET, RETI, RST
+    PROFILE_CLASS_STACK,   // PUSH, POP
+    PROFILE_CLASS_CB,      // every CB-prefixed instruction
+    PROFILE_CLASS_CONTROL, // NOP, HALT, STOP, DI, EI, illegal opcodes
+    PROFILE_CLASS_COUNT,
+} profile_class;
+
+typedef struct {
+    uint64_t count[PROFILE_OPCODES];
+    uint64_t cycles[PROFILE_OPCODES];
+    uint64_t class_ns[PROFILE_CLASS_COUNT];      // host time of the sampled instructions
+    uint64_t class_samples[PROFILE_CLASS_COUNT]; // number of sampled instructions
+    uint32_t tick;
+} profile_data;
+
+struct gb_instance;
+
+// the opcode's slot in count/cycles; the CB operand byte is already in imm
+static inline uint16_t profile_key(uint8_t opcode, uint16_t imm) {
+    return opcode == 0xCB ? 0x100 + (uint8_t)imm : opcode;
+}
+
+static inline uint64_t profile_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline int profile_should_sample(profile_data *p) {
+    return (++p->tick & PROFILE_SAMPLE_MASK) == 0;
+}
+
+static inline void profile_count(profile_data *p, uint16_t key, uint64_t cycles) {
+    p->count[key]++;
+    p->cycles[key] += cycles;
+}
+
+profile_class profile_class_of(uint16_t key);
+void profile_sample(profile_data *p, uint16_t key, uint64_t ns);
+
+void profile_reset(struct gb_instance *gb);
+const profile_data *profile_get(struct gb_instance *gb);
+// estimated host ns spent in a class: mean of its samples times its execution count
+uint64_t profile_class_ns(struct gb_instance *gb, profile_class cls);
+const char *profile_class_name(profile_class cls);
+// one row per executed opcode: opcode,mnemonic,class,count,cycles,cycles_per_exec,class_ns_per_exec
+int profile_write_csv(struct gb_instance *gb, FILE *out);
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef __SCHED_H
+#define __SCHED_H
+
+#include <stdint.h>
+
+// every source of timed work, each has at most one pending deadline
+typedef enum {
+    SCHED_TIMER,
+    SCHED_PPU,
+    SCHED_SERIAL,
+    SCHED_APU,
+    SCHED_OAM_DMA,
+    SCHED_HDMA,
+#ifdef GB_PROFILE
+    SCHED_HOTSPOT, // PC sampler, see hotspot.h
+#endif
+    SCHED_EVENT_COUNT,
+} sched_event;
+
+struct gb_instance;
+
+// when is the cycle the event was due at; cpu.cycles may already be a few cycles past it
+typedef void (*sched_callback)(struct gb_instance *gb, uint64_t when);
+
+/**
+ * Event scheduler, a min-heap of (deadline, event) indexed by event so a
+ * peripheral can move or cancel its deadline in O(log n). The earliest
+ * deadline is mirrored in gb_instance.next_event, which is the only value
+ * the run loop looks at.
+ */
+typedef struct {
+    uint64_t when[SCHED_EVENT_COUNT];
+    sched_callback handler[SCHED_EVENT_COUNT];
+    uint8_t heap[SCHED_EVENT_COUNT]; // pending events, earliest first
+    int8_t pos[SCHED_EVENT_COUNT];   // index into heap, -1 when not pending
+    uint8_t size;
+} scheduler;
+
+void sched_init(struct gb_instance *gb);
+void sched_set_handler(struct gb_instance *gb, sched_event event, sched_callback handler);
+void sched_add(struct gb_instance *gb, sched_event event, uint64_t when);
+void sched_cancel(struct gb_instance *gb, sched_event event);
+void sched_run(struct gb_instance *gb);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef __STATICREC_H
+#define __STATICREC_H
+
+#include <stdint.h>
+
+#define STATICREC_ADDR_SPACE 0x8000 // blocks are indexed by entry pc, 0000-7FFF
+
+struct gb_instance;
+
+typedef void (*staticrec_block_t)(struct gb_instance *gb);
+
+typedef struct {
+    staticrec_block_t run;
+    uint16_t cycles; // worst case for one run, every branch taken
+} staticrec_block;
+
+/**
+ * A ROM translated ahead of time by gb_staticrec. Each block runs the guest
+ * instructions from its entry pc up to the next control transfer. Any pc
+ * without a block, and anything outside ROM, goes to the interpreter.
+ *
+ * Like a JIT block, a block only starts when its worst case fits before
+ * run_deadline, otherwise staticrec_run steps the interpreter. A store in
+ * the middle of a block is followed by a run_deadline check, since an
+ * IE/IF write can raise an interrupt there.
+ */
+typedef struct staticrec_image {
+    uint16_t global_checksum; // from the cart header, an image only attaches to its own ROM
+    uint16_t rom_bank;        // bank the 4000-7FFF blocks were translated from
+    uint32_t block_count;
+    const staticrec_block *blocks;
+} staticrec_image;
+
+int staticrec_attach(struct gb_instance *gb, const staticrec_image *image);
+void staticrec_run(struct gb_instance *gb);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Execution trace. Fixed-size binary records go into a per-instance ring
+ * buffer that keeps the most recent GB_TRACE_RECORDS of them; nothing is
+ * formatted until the buffer is dumped (trace_dump on demand, or the crash
+ * handler). GB_TRACE_LEVEL is the most the build can record, set with
+ * -DGB_TRACE=EVENT|INSTR. Levels above it compile to nothing, and
+ * trace_set_level picks what is recorded at run time. Instructions are
+ * recorded on the interpreter paths; blocks run by the JIT or the static
+ * recompiler are not.
+ */
+#define TRACE_LEVEL_OFF   0
+#define TRACE_LEVEL_EVENT 1 // interrupts and other rare machine events
+#define TRACE_LEVEL_INSTR 2 // every instruction executed
+
+#ifndef GB_TRACE_LEVEL
+#define GB_TRACE_LEVEL TRACE_LEVEL_OFF
+#endif
+
+#ifndef GB_TRACE_RECORDS
+#define GB_TRACE_RECORDS 4096 // power of two
+#endif
+
+#define TRACE_CRASH_SLOTS 8 // instances the crash handler can dump at once
+
+typedef enum {
+    TRACE_KIND_INSTR, // arg is the operand
+    TRACE_KIND_IRQ,   // arg is the vector taken
+} trace_kind;
+
+// 24 bytes; registers are the state before the instruction runs
+typedef struct {
+    uint64_t cycles;
+    uint16_t pc, sp, af, bc, de, hl;
+    uint16_t arg;
+    uint8_t kind;
+    uint8_t opcode;
+} trace_record;
+
+#if GB_TRACE_LEVEL > TRACE_LEVEL_OFF
+
+/**
+ * Single producer, the thread running the instance. A record is filled in
+ * before head moves past it, so a reader (the crash handler included) only
+ * ever sees whole records.
+ */
+typedef struct {
+    uint8_t level;  // runtime level, never above GB_TRACE_LEVEL
+    uint64_t head;  // records written so far, the next one goes to head % GB_TRACE_RECORDS
+    trace_record ring[GB_TRACE_RECORDS];
+} trace_buffer;
+
+struct gb_instance;
+
+void trace_set_level(struct gb_instance *gb, uint8_t level);
+void trace_write(struct gb_instance *gb, trace_kind kind, uint16_t pc, uint8_t opcode, uint16_t arg);
+void trace_clear(struct gb_instance *gb);
+
+// oldest record first, records are copied out, returns how many
+uint32_t trace_snapshot(struct gb_instance *gb, trace_record *out, uint32_t max);
+int trace_dump(struct gb_instance *gb, FILE *out);
+// raw records to a file descriptor, async-signal-safe
+int trace_dump_fd(struct gb_instance *gb, int fd);
+/**
+ * Dump the ring to path when the process dies on SIGSEGV, SIGBUS, SIGILL,
+ * SIGFPE or SIGABRT; path is only created then. Every registered instance
+ * is dumped to its own path, so give each one a different file. Fails when
+ * TRACE_CRASH_SLOTS instances are already registered. gb_destroy removes
+ * the instance.
+ */
+int trace_install_crash_handler(struct gb_instance *gb, const char *path);
+void trace_remove_crash_handler(struct gb_instance *gb);
+
+#define TRACE_EVENT(gb, kind, pc, arg)                          \
+    do {                                                        \
+        if ((gb)->trace.level >= TRACE_LEVEL_EVENT) {           \
+            trace_write((gb), (kind), (pc), 0, (arg));          \
+        }                                                       \
+    } while (0)
+#else
+#define TRACE_EVENT(gb, kind, pc, arg) ((void)0)
+#endif
+
+#if GB_TRACE_LEVEL >= TRACE_LEVEL_INSTR
+// pc is the instruction's own address, opcode and imm are already fetched
+#define TRACE_INSTR(gb, pc)                                                              \
+    do {                                                                                 \
+        if ((gb)->trace.level >= TRACE_LEVEL_INSTR) {                                    \
+            trace_write((gb), TRACE_KIND_INSTR, (pc), (gb)->cpu.opcode, (gb)->cpu.imm);  \
+        }                                                                                \
+    } while (0)
+#else
+#define TRACE_INSTR(gb, pc) ((void)(pc))
+#endif
+
+#endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "bus.h"
 #include "cart.h"
+#include "gb.h"
+#include "io.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -23,65 +25,224 @@ FFFF	FFFF	Interrupt Enable register (IE)
 ------------------------------------------------------------------------------------------------------
 */
 
-// 8kB = 8192B
+#define BUS_PAGE_SIZE 0x100
 
-static uint8_t vram[8192];
-static uint8_t wram[8192];
-static uint8_t oam[160];
-static uint8_t hram[128];
+static void bus_map_range(gb_instance *gb, uint16_t start, uint16_t end, uint8_t *base, bool writable) {
+    for (uint32_t page = start >> 8; page <= (uint32_t)(end >> 8); page++) {
+        gb->map.read[page] = base;
+        gb->map.write[page] = writable ? base : NULL;
+        base += BUS_PAGE_SIZE;
+    }
+}
 
-void mem_init() {
-    memset(vram, 0, sizeof(uint8_t) * 8192);
-    memset(wram, 0, sizeof(uint8_t) * 8192);
-    memset(oam,  0, sizeof(uint8_t) * 160);
-    memset(hram, 0, sizeof(uint8_t) * 128);
+// read-only, shared by every instance for ROM pages past the end of the image
+static uint8_t bus_open_page[BUS_PAGE_SIZE];
+
+// a page cut by the end of the image stays on cart_mem_read, which reads 0xFF past it
+static void bus_map_rom(gb_instance *gb, uint16_t start, uint32_t offset) {
+    for (uint32_t page = 0; page < 0x4000 / BUS_PAGE_SIZE; page++, offset += BUS_PAGE_SIZE) {
+        uint32_t index = (start >> 8) + page;
+        if (offset + BUS_PAGE_SIZE <= gb->cart.rom_size) {
+            gb->map.read[index] = gb->cart.rom_data + offset;
+        } else {
+            gb->map.read[index] = offset >= gb->cart.rom_size ? bus_open_page : NULL;
+        }
+        gb->map.write[index] = NULL;
+    }
 }
 
-uint8_t bus_read(uint16_t addr) {
-    if (addr <= 0x7FFF) { // cart rom
-        return cart_mem_read(addr);
+static void bus_write_vbk(gb_instance *gb, uint16_t addr, uint8_t data) {
+    (void)addr;
+    bus_set_vram_bank(gb, data);
+}
+
+static void bus_write_svbk(gb_instance *gb, uint16_t addr, uint8_t data) {
+    (void)addr;
+    bus_set_wram_bank(gb, data);
+}
+
+void mem_init(gb_instance *gb) {
+    memset(gb->bus.vram, 0, sizeof(gb->bus.vram));
+    memset(gb->bus.wram, 0, sizeof(gb->bus.wram));
+    memset(gb->bus.oam,  0, sizeof(uint8_t) * 160);
+    memset(gb->bus.hram, 0, sizeof(uint8_t) * 128);
+    gb->bus.vram_bank = 0;
+    gb->bus.wram_bank = 1;
+    memset(bus_open_page, 0xFF, sizeof(bus_open_page));
+    bus_map_reset(gb);
+
+    if (gb->cgb) {
+        io_set_handler(gb, 0xFF4F, NULL, bus_write_vbk);
+        io_set_handler(gb, 0xFF70, NULL, bus_write_svbk);
+    }
+}
+
+void bus_map_reset(gb_instance *gb) {
+    memset(&gb->map, 0, sizeof(bus_map));
+    bus_map_rom(gb, 0x0000, 0);
+    bus_map_rom_bank(gb);
+    bus_map_range(gb, 0x8000, 0x9FFF, gb->bus.vram[gb->bus.vram_bank], true);
+    bus_map_range(gb, 0xC000, 0xCFFF, gb->bus.wram[0], true);
+    bus_map_range(gb, 0xD000, 0xDFFF, gb->bus.wram[gb->bus.wram_bank], true);
+
+    for (uint16_t page = 0; page < sizeof(gb->decode.wram_pages); page++) {
+        if (gb->decode.wram_pages[page]) {
+            bus_watch_writes(gb, 0xC000 + (page << 8));
+        }
+    }
+}
+
+void bus_unmap(gb_instance *gb, uint16_t start, uint16_t end) {
+    for (uint32_t page = start >> 8; page <= (uint32_t)(end >> 8); page++) {
+        gb->map.read[page] = NULL;
+        gb->map.write[page] = NULL;
     }
+}
 
-    if (addr <= 0x9FFF) { // vram
-        return vram[addr - 0x8000];
+// a window an OAM DMA lock unmapped stays unmapped, the map is rebuilt from the banks when it ends
+void bus_set_vram_bank(gb_instance *gb, uint8_t bank) {
+    gb->bus.vram_bank = bank & 0x01;
+    if (!oam_dma_locks(gb, 0x8000)) {
+        bus_map_range(gb, 0x8000, 0x9FFF, gb->bus.vram[gb->bus.vram_bank], true);
     }
+}
 
-    if (addr <= 0xBFFF) { // cart ram
-        return cart_mem_read(addr);
+void bus_set_wram_bank(gb_instance *gb, uint8_t bank) {
+    bank &= 0x07;
+    if (bank == 0) {
+        bank = 1;
+    }
+    if (bank == gb->bus.wram_bank) {
+        return ;
     }
 
-    if (addr <= 0xDFFF) { // work ram
-        return wram[addr - 0xC000];
+    gb->bus.wram_bank = bank;
+    // decoded entries are keyed by address, the code under them just changed
+    if (decode_invalidate_wram_bank(gb)) {
+#ifdef GB_HAVE_JIT
+        if (gb->jit != NULL) {
+            jit_invalidate_range(gb, 0xCFFE, 0xDFFF);
+        }
+#endif
     }
+    if (!oam_dma_locks(gb, 0xD000)) {
+        bus_map_range(gb, 0xD000, 0xDFFF, gb->bus.wram[bank], true);
+    }
+}
 
+// call whenever cart.rom_bank changes
+void bus_map_rom_bank(gb_instance *gb) {
+    if (!oam_dma_locks(gb, 0x4000)) {
+        bus_map_rom(gb, 0x4000, (uint32_t)gb->cart.rom_bank * 0x4000);
+    }
+}
+
+void bus_watch_writes(gb_instance *gb, uint16_t addr) {
+    gb->map.write[addr >> 8] = NULL;
+}
+
+// the FFxx page is the one polled all the time, so it goes first
+static uint8_t bus_read_slow(gb_instance *gb, uint16_t addr) {
     if (addr >= 0xFF80 && addr <= 0xFFFE) { // high ram
-        return hram[addr - 0xFF80];
+        return gb->bus.hram[addr - 0xFF80];
+    }
+
+    if (addr >= 0xFF00) { // i/o registers, interrupt enable
+        return io_read(gb, addr);
+    }
+
+    if (gb->oam_dma.active && oam_dma_conflict(gb, addr)) { // see dma.h
+        return addr >= 0xFE00 ? 0xFF : gb->oam_dma.value;
+    }
+
+    if (addr >= 0xFE00 && addr <= 0xFE9F) { // oam
+        return gb->bus.oam[addr - 0xFE00];
+    }
+
+    if (addr <= 0x7FFF) { // cart rom
+        return cart_mem_read(gb, addr);
+    }
+
+    if (addr >= 0xA000 && addr <= 0xBFFF) { // cart ram
+        return cart_mem_read(gb, addr);
     }
 
     printf("unsupport bus read address 0x%04X\n", addr);
     return 0x00;
 }
 
-void bus_write(uint16_t addr, uint8_t data) {
-    if (addr <= 0x7FFF) { // cart rom
-        cart_mem_write(addr, data);
+uint8_t bus_read(gb_instance *gb, uint16_t addr) {
+    const uint8_t *page = gb->map.read[addr >> 8];
+
+    if (page != NULL) {
+        return page[addr & 0xFF];
     }
+    return bus_read_slow(gb, addr);
+}
 
-    if (addr <= 0x9FFF) { // vram
-        vram[addr - 0x8000] = data;
+static void bus_write_slow(gb_instance *gb, uint16_t addr, uint8_t data) {
+    if (addr >= 0xFF80 && addr <= 0xFFFE) { // high ram
+        gb->bus.hram[addr - 0xFF80] = data;
+        if (gb->decode.hram_decoded) {
+            decode_invalidate_hram(gb, addr);
+#ifdef GB_HAVE_JIT
+            if (gb->jit != NULL) {
+                jit_invalidate(gb, addr);
+            }
+#endif
+        }
+        return ;
     }
 
-    if (addr <= 0xBFFF) { // cart ram
-        cart_mem_write(addr, data);
+    if (addr >= 0xFF00) { // i/o registers, interrupt enable
+        io_write(gb, addr, data);
+        return ;
     }
 
-    if (addr <= 0xDFFF) { // work ram
-        wram[addr - 0xC000] = data;
+    if (gb->oam_dma.active && oam_dma_conflict(gb, addr)) { // see dma.h
+        return ;
     }
 
-    if (addr >= 0xFF80 && addr <= 0xFFFE) { // high ram
-        hram[addr - 0xFF80] = data;
+    if (addr >= 0xFE00 && addr <= 0xFE9F) { // oam
+        gb->bus.oam[addr - 0xFE00] = data;
+        return ;
+    }
+
+    if (addr <= 0x7FFF) { // cart rom
+        cart_mem_write(gb, addr, data);
+        return ;
+    }
+
+    if (addr >= 0xA000 && addr <= 0xBFFF) { // cart ram
+        cart_mem_write(gb, addr, data);
+        return ;
+    }
+
+    if (addr >= 0xC000 && addr <= 0xDFFF) { // work ram holding decoded code
+        *bus_wram(&gb->bus, addr) = data;
+        if (gb->decode.wram_pages[(addr - 0xC000) >> 8]) {
+            decode_invalidate_wram(gb, addr);
+#ifdef GB_HAVE_JIT
+            if (gb->jit != NULL) {
+                jit_invalidate(gb, addr);
+            }
+#endif
+        } else {
+            // decode_init dropped the page and the JIT blocks on it, plain stores are safe again
+            gb->map.write[addr >> 8] = gb->map.read[addr >> 8];
+        }
+        return ;
     }
 
     printf("unsupport bus write address 0x%04X\n", addr);
+}
+
+void bus_write(gb_instance *gb, uint16_t addr, uint8_t data) {
+    uint8_t *page = gb->map.write[addr >> 8];
+
+    if (page != NULL) {
+        page[addr & 0xFF] = data;
+        return ;
+    }
+    bus_write_slow(gb, addr, data);
 }
\ No newline at end of file
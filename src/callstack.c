@@ -0,0 +1,152 @@
+#ifdef GB_PROFILE
+
+#include "callstack.h"
+#include "gb.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CALLSTACK_KIND_SHIFT 28
+#define CALLSTACK_RAM (1u << 27) // target in 8000-FFFF, which has no ROM bank
+#define CALLSTACK_BANK_MASK 0x7FF // bits 16-26, every bank an MBC5 can select
+#define CALLSTACK_INITIAL_NODES 256
+
+static uint32_t callstack_key(gb_instance *gb, uint16_t target, callstack_kind kind) {
+    uint32_t key = (uint32_t)kind << CALLSTACK_KIND_SHIFT | target;
+
+    if (target >= 0x8000) {
+        key |= CALLSTACK_RAM;
+    } else if (target >= 0x4000) {
+        key |= (uint32_t)(gb->cart.rom_bank & CALLSTACK_BANK_MASK) << 16;
+    }
+    return key;
+}
+
+// everything since the last transition belongs to the routine that was running
+static void callstack_charge(gb_instance *gb) {
+    callstack_data *c = &gb->callstack;
+
+    c->nodes[c->current].cycles += gb->cpu.cycles - c->last_cycles;
+    c->last_cycles = gb->cpu.cycles;
+}
+
+static uint32_t callstack_child(callstack_data *c, uint32_t parent, uint32_t key) {
+    for (uint32_t i = c->nodes[parent].first_child; i != 0; i = c->nodes[i].next_sibling) {
+        if (c->nodes[i].key == key) {
+            return i;
+        }
+    }
+
+    if (c->node_count == c->node_capacity) {
+        callstack_node *nodes = (callstack_node *)realloc(c->nodes, c->node_capacity * 2 * sizeof(callstack_node));
+        if (nodes == NULL) {
+            return parent;
+        }
+        c->nodes = nodes;
+        c->node_capacity *= 2;
+    }
+
+    uint32_t child = c->node_count++;
+    memset(&c->nodes[child], 0, sizeof(callstack_node));
+    c->nodes[child].key = key;
+    c->nodes[child].parent = parent;
+    c->nodes[child].next_sibling = c->nodes[parent].first_child;
+    c->nodes[parent].first_child = child;
+    return child;
+}
+
+void callstack_start(gb_instance *gb) {
+    callstack_data *c = &gb->callstack;
+
+    callstack_stop(gb);
+    c->nodes = (callstack_node *)calloc(CALLSTACK_INITIAL_NODES, sizeof(callstack_node));
+    if (c->nodes == NULL) {
+        return ;
+    }
+
+    c->node_count = 1;
+    c->node_capacity = CALLSTACK_INITIAL_NODES;
+    c->last_cycles = gb->cpu.cycles;
+}
+
+void callstack_stop(gb_instance *gb) {
+    free(gb->callstack.nodes);
+    memset(&gb->callstack, 0, sizeof(callstack_data));
+}
+
+void callstack_enter(gb_instance *gb, uint16_t target, callstack_kind kind) {
+    callstack_data *c = &gb->callstack;
+
+    if (c->depth == CALLSTACK_MAX_DEPTH) {
+        c->overflows++;
+        return ;
+    }
+
+    callstack_charge(gb);
+    c->frames[c->depth].caller = c->current;
+    c->frames[c->depth].sp = gb->cpu.reg.sp;
+    c->depth++;
+    c->current = callstack_child(c, c->current, callstack_key(gb, target, kind));
+}
+
+void callstack_leave(gb_instance *gb, uint16_t sp) {
+    callstack_data *c = &gb->callstack;
+
+    // a routine that dropped its own return address unwinds every frame above the one returned to
+    for (uint32_t i = c->depth; i-- > 0;) {
+        if (c->frames[i].sp == sp) {
+            callstack_charge(gb);
+            c->current = c->frames[i].caller;
+            c->depth = i;
+            return ;
+        }
+    }
+    c->unmatched++;
+}
+
+static void callstack_frame_name(char *out, uint32_t key) {
+    uint16_t bank = (uint16_t)(key >> 16 & CALLSTACK_BANK_MASK);
+    uint16_t addr = (uint16_t)key;
+
+    if ((key >> CALLSTACK_KIND_SHIFT) == CALLSTACK_IRQ) {
+        sprintf(out, "int_%04X", addr);
+    } else if (key & CALLSTACK_RAM) {
+        sprintf(out, "ram_%04X", addr);
+    } else {
+        sprintf(out, "%02X_%04X", bank, addr);
+    }
+}
+
+static void callstack_write_node(callstack_data *c, uint32_t node, char *path, size_t length, FILE *out) {
+    if (node != 0) {
+        path[length++] = ';';
+        callstack_frame_name(path + length, c->nodes[node].key);
+        length += strlen(path + length);
+    }
+
+    if (c->nodes[node].cycles != 0) {
+        fprintf(out, "%s %llu\n", path, (unsigned long long)c->nodes[node].cycles);
+    }
+    for (uint32_t i = c->nodes[node].first_child; i != 0; i = c->nodes[i].next_sibling) {
+        callstack_write_node(c, i, path, length, out);
+    }
+}
+
+int callstack_write_folded(gb_instance *gb, FILE *out) {
+    callstack_data *c = &gb->callstack;
+    // "main" plus one ";BBB_AAAA" per level
+    char path[8 + CALLSTACK_MAX_DEPTH * 9 + 1];
+
+    if (c->nodes == NULL) {
+        return -1;
+    }
+
+    callstack_charge(gb);
+    strcpy(path, "main");
+    callstack_write_node(c, 0, path, strlen(path), out);
+    return ferror(out) ? -1 : 0;
+}
+
+#endif
@@ -1,42 +1,62 @@
 #include "cart.h"
+#include "gb.h"
 
 #include <stdint.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #define POSIX
-#define DEBUG
 
-static int cart_read(const char *cart_path);
+static int cart_read(gb_instance *gb, const char *cart_path);
 static const char *get_cart_type(uint8_t type);
 static const char *get_cart_ram_size(uint8_t ram_size_code);
 static const char *get_cart_lic_code(uint8_t lic_code);
 
-static uint8_t *rom_data = NULL;
-static uint32_t rom_size;
+int cart_init(gb_instance *gb, const char *cart_path) {
+    if (cart_read(gb, cart_path)) {
+        printf("rom load fail!\n");
+        return 1;
+    }
 
-void cart_init(const char *cart_path) {
-    if (cart_read(cart_path)) {
+    gb->cart.rom_bank = 1;
+    return 0;
+}
+
+int cart_init_rom(gb_instance *gb, const uint8_t *rom_data, uint32_t rom_size) {
+    gb->cart.rom_data = (uint8_t *)malloc(rom_size * sizeof(uint8_t));
+    if (gb->cart.rom_data == NULL) {
         printf("rom load fail!\n");
-        return ;
+        return 1;
     }
 
-    cart_header *header = (cart_header *)(rom_data + 0x0100);
+    memcpy(gb->cart.rom_data, rom_data, rom_size);
+    gb->cart.rom_size = rom_size;
+    gb->cart.rom_bank = 1;
+    return 0;
+}
+
+void cart_print_header(gb_instance *gb) {
+    cart_header *header = (cart_header *)(gb->cart.rom_data + 0x0100);
     const char *cart_type     = get_cart_type(header->cart_type);
     const char *cart_ram_size = get_cart_ram_size(header->ram_size);
     const char *cart_lic_code = get_cart_lic_code(header->old_lic_code);
 
-#ifdef DEBUG
     printf("CART NAME:%s\nCART TYPE:%s\nCART RAM SIZE:%s\nCART LIC CODE:%s\n",
            header->title, cart_type, cart_ram_size, cart_lic_code);
-#endif
 }
 
-static int cart_read(const char *cart_path) {
+void cart_free(gb_instance *gb) {
+    free(gb->cart.rom_data);
+    gb->cart.rom_data = NULL;
+    gb->cart.rom_size = 0;
+}
+
+static int cart_read(gb_instance *gb, const char *cart_path) {
 #ifdef POSIX
     int fd = open(cart_path, O_RDONLY);
     if (fd < 0) {
@@ -49,9 +69,9 @@ static int cart_read(const char *cart_path) {
         return 1;
     }
 
-    rom_size = st.st_size;
-    rom_data = (char *)malloc(rom_size * sizeof(char));
-    read(fd, rom_data, rom_size);
+    gb->cart.rom_size = st.st_size;
+    gb->cart.rom_data = (uint8_t *)malloc(gb->cart.rom_size * sizeof(uint8_t));
+    read(fd, gb->cart.rom_data, gb->cart.rom_size);
     close(fd);
 #endif
     return 0;
@@ -142,10 +162,22 @@ static const char *get_cart_lic_code(uint8_t lic_code) {
     return "UNKNOWN";
 }
 
-uint8_t cart_mem_read(uint16_t addr) {
-    return rom_data[addr];
+// 0143 bit 7: 0x80 carts also run on a DMG, 0xC0 ones are CGB only
+bool cart_cgb(gb_instance *gb) {
+    return gb->cart.rom_size > 0x0143 && (gb->cart.rom_data[0x0143] & 0x80) != 0;
+}
+
+uint8_t cart_mem_read(gb_instance *gb, uint16_t addr) {
+    uint32_t offset = addr;
+
+    if (addr >= 0x4000 && addr <= 0x7FFF) {
+        offset = (uint32_t)gb->cart.rom_bank * 0x4000 + (addr - 0x4000);
+    }
+
+    // past the end of the image, the bus floats high
+    return offset < gb->cart.rom_size ? gb->cart.rom_data[offset] : 0xFF;
 }
 
-void cart_mem_write(uint16_t addr, uint8_t data) {
+void cart_mem_write(gb_instance *gb, uint16_t addr, uint8_t data) {
     printf("unsupport cart write\n");
 }
\ No newline at end of file
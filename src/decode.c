@@ -0,0 +1,382 @@
+#include "decode.h"
+#include "gb.h"
+#include "bus.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// clang-format off
+const uint8_t instruction_length[256] = {
+    1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
+    2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+    2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+    2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,
+    1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,
+    2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+    2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+};
+
+// M-cycles with conditional branches not taken, 0xCB is filled in from the CB opcode
+const uint8_t instruction_cycles[256] = {
+    1, 3, 2, 2, 1, 1, 2, 1, 5, 2, 2, 2, 1, 1, 2, 1,
+    1, 3, 2, 2, 1, 1, 2, 1, 3, 2, 2, 2, 1, 1, 2, 1,
+    2, 3, 2, 2, 1, 1, 2, 1, 2, 2, 2, 2, 1, 1, 2, 1,
+    2, 3, 2, 2, 3, 3, 3, 1, 2, 2, 2, 2, 1, 1, 2, 1,
+    1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
+    1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
+    1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
+    2, 2, 2, 2, 2, 2, 1, 2, 1, 1, 1, 1, 1, 1, 2, 1,
+    1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
+    1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
+    1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
+    1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1,
+    2, 3, 3, 4, 3, 4, 2, 4, 2, 4, 3, 2, 3, 6, 2, 4,
+    2, 3, 3, 1, 3, 4, 2, 4, 2, 4, 3, 1, 3, 1, 2, 4,
+    3, 3, 2, 1, 1, 4, 2, 4, 4, 1, 4, 1, 1, 1, 2, 4,
+    3, 3, 2, 1, 1, 4, 2, 4, 3, 2, 4, 1, 1, 1, 2, 4,
+};
+// clang-format on
+
+void decode_init(gb_instance *gb) {
+    decode_free(gb);
+    memset(&gb->decode, 0, sizeof(decode_cache));
+#ifdef GB_HAVE_JIT
+    // RAM blocks are only dropped through the page watches cleared above
+    if (gb->jit != NULL) {
+        jit_invalidate_range(gb, 0x0000, 0xFFFF);
+    }
+#endif
+}
+
+void decode_free(gb_instance *gb) {
+    decode_drop_rom(gb);
+    free(gb->decode.wram);
+    gb->decode.wram = NULL;
+}
+
+// fusions are only made in ROM, so this is all a change of fusion rules has to redecode
+void decode_drop_rom(gb_instance *gb) {
+    for (int i = 0; i < DECODE_ROM_BANKS; i++) {
+        free(gb->decode.rom[i]);
+        gb->decode.rom[i] = NULL;
+    }
+}
+
+static decoded_instruction *decode_bank(decoded_instruction **bank, uint32_t size) {
+    if (*bank == NULL) {
+        *bank = (decoded_instruction *)calloc(size, sizeof(decoded_instruction));
+    }
+
+    return *bank;
+}
+
+// find the slot for pc, allocating its bank on first use; NULL when pc is not cacheable
+static decoded_instruction *decode_slot(gb_instance *gb, uint16_t pc) {
+    decoded_instruction *bank;
+
+    if (pc <= 0x3FFF) {
+        bank = decode_bank(&gb->decode.rom[0], DECODE_BANK_SIZE);
+        return bank ? &bank[pc] : NULL;
+    }
+
+    if (pc <= 0x7FFF) {
+        bank = decode_bank(&gb->decode.rom[gb->cart.rom_bank % DECODE_ROM_BANKS], DECODE_BANK_SIZE);
+        return bank ? &bank[pc - 0x4000] : NULL;
+    }
+
+    if (pc >= 0xC000 && pc <= 0xDFFF) {
+        bank = decode_bank(&gb->decode.wram, DECODE_WRAM_SIZE);
+        return bank ? &bank[pc - 0xC000] : NULL;
+    }
+
+    if (pc >= 0xFF80 && pc <= 0xFFFE) {
+        return &gb->decode.hram[pc - 0xFF80];
+    }
+
+    return NULL;
+}
+
+#ifdef GB_FUSION
+#define IDLE_LOOP_MAX_BYTES 16
+
+// the ROM byte at addr, or 0xD3 (not an instruction) past the end of pc's region or the ROM
+static uint8_t decode_peek(gb_instance *gb, uint16_t pc, uint32_t addr) {
+    uint16_t region_end = pc <= 0x3FFF ? 0x4000 : 0x8000;
+    uint32_t base = pc <= 0x3FFF ? 0 : (uint32_t)gb->cart.rom_bank * 0x4000 - 0x4000;
+
+    return addr < region_end && base + addr < gb->cart.rom_size ? bus_read(gb, (uint16_t)addr) : 0xD3;
+}
+
+/**
+ * A short loop that branches back to pc and never writes memory or leaves
+ * through anything but its own branch. Returns its length in bytes, 0 if
+ * the code at pc is something else. Whether it really is idle (every pass
+ * leaves the same state) is checked when it runs, see idle_loop_run.
+ */
+static uint16_t decode_idle_loop(gb_instance *gb, uint16_t pc) {
+    uint32_t addr = pc;
+
+    while (addr < (uint32_t)pc + IDLE_LOOP_MAX_BYTES) {
+        decoded_instruction entry;
+        uint16_t target = 0;
+
+        entry.opcode = decode_peek(gb, pc, addr);
+        entry.length = instruction_length[entry.opcode];
+        entry.operand = decode_peek(gb, pc, addr + 1);
+        if (entry.length == 3) {
+            entry.operand |= (uint16_t)decode_peek(gb, pc, addr + 2) << 8;
+        }
+
+        decode_flow flow = decode_flow_of(&entry, (uint16_t)addr, &target);
+        addr += entry.length;
+
+        if (flow == FLOW_BRANCH && target == pc && entry.opcode != 0xC4 && entry.opcode != 0xCC &&
+            entry.opcode != 0xD4 && entry.opcode != 0xDC) {
+            return (uint16_t)(addr - pc);
+        }
+        if (flow != FLOW_NEXT || decode_writes_memory(entry.opcode, (uint8_t)entry.operand)) {
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Match the idioms in decode_fused against the bytes at pc. Only ROM code is
+ * fused: its bytes never change, so the head entry can not go stale when a
+ * later instruction of the sequence is overwritten.
+ */
+static uint8_t decode_fuse(gb_instance *gb, uint16_t pc, uint16_t *operand, bool allow_idle) {
+    uint8_t b[6];
+
+    if (allow_idle && gb->idle_skip && gb->accuracy == GB_ACCURACY_FAST) {
+        uint16_t length = decode_idle_loop(gb, pc);
+        if (length != 0) {
+            *operand = length;
+            return FUSED_IDLE_LOOP;
+        }
+    }
+
+    for (uint32_t i = 0; i < sizeof(b); i++) {
+        b[i] = decode_peek(gb, pc, (uint32_t)pc + i);
+    }
+
+    switch (b[0]) {
+    case 0x2A:
+        if (b[1] == 0x12) {
+            return b[2] == 0x13 ? FUSED_COPY_HLI_TO_DE : FUSED_LDI_A_MHL_LD_MDE_A;
+        }
+        break;
+    case 0x1A:
+        if (b[1] == 0x22 && b[2] == 0x13) {
+            return FUSED_COPY_DE_TO_HLI;
+        }
+        break;
+    case 0x05: case 0x0D: case 0x15: case 0x1D: case 0x3D:
+        if (b[1] == 0x20) {
+            static const uint8_t dec_jr[8] = {
+                FUSED_DEC_B_JR_NZ, FUSED_DEC_C_JR_NZ, FUSED_DEC_D_JR_NZ, FUSED_DEC_E_JR_NZ,
+                FUSED_NONE, FUSED_NONE, FUSED_NONE, FUSED_DEC_A_JR_NZ,
+            };
+            *operand = b[2];
+            return dec_jr[b[0] >> 3];
+        }
+        break;
+    case 0x0B:
+        if (b[1] == 0x78 && b[2] == 0xB1 && b[3] == 0x20) {
+            *operand = b[4];
+            return FUSED_DEC_BC_JR_NZ;
+        }
+        break;
+    case 0xF0:
+        if (b[2] == 0xFE && (b[4] == 0x20 || b[4] == 0x28)) {
+            *operand = (uint16_t)(b[3] | b[5] << 8);
+            return b[4] == 0x20 ? FUSED_LDH_CP_JR_NZ : FUSED_LDH_CP_JR_Z;
+        }
+        break;
+    }
+
+    return FUSED_NONE;
+}
+#endif
+
+decoded_instruction *decode_fill(gb_instance *gb, uint16_t pc, decoded_instruction *entry) {
+    if (entry == NULL) {
+        entry = decode_slot(gb, pc);
+    }
+
+    if (entry == NULL) {
+        entry = &gb->decode.scratch;
+    }
+
+    uint8_t opcode = bus_read(gb, pc);
+    uint8_t length = instruction_length[opcode];
+    uint16_t operand = 0;
+
+    if (length == 2) {
+        operand = bus_read(gb, pc + 1);
+    } else if (length == 3) {
+        operand = bus_read16(gb, pc + 1);
+    }
+
+    // flag every RAM page the instruction's bytes touch, so a write to any of them is noticed
+    if (pc >= 0xFF80 && pc <= 0xFFFE) {
+        gb->decode.hram_decoded = 1;
+    } else if (pc >= 0xC000 && pc <= 0xDFFF && entry != &gb->decode.scratch) {
+        gb->decode.wram_pages[(pc - 0xC000) >> 8] = 1;
+        gb->decode.wram_pages[((pc - 0xC000 + length - 1) & 0x1FFF) >> 8] = 1;
+        bus_watch_writes(gb, pc);
+        bus_watch_writes(gb, 0xC000 + ((pc - 0xC000 + length - 1) & 0x1FFF));
+    }
+
+    entry->opcode = opcode;
+    entry->operand = operand;
+    entry->cycles = instruction_cycles[opcode];
+    entry->length = length;
+
+    if (opcode == 0xCB) {
+        // BIT n,(HL) only reads, the other (HL) forms read and write back
+        entry->cycles = (operand & 0x07) != 0x06 ? 2 : ((operand & 0xC0) == 0x40 ? 3 : 4);
+    }
+
+    entry->fused = FUSED_NONE;
+    entry->fused_operand = 0;
+#ifdef GB_FUSION
+    if (pc <= 0x7FFF && entry != &gb->decode.scratch) {
+        entry->fused = decode_fuse(gb, pc, &entry->fused_operand, true);
+    }
+#endif
+
+    return entry;
+}
+
+// pc is the instruction's own address; target is only written for fixed targets
+decode_flow decode_flow_of(const decoded_instruction *entry, uint16_t pc, uint16_t *target) {
+    uint16_t next = (uint16_t)(pc + entry->length);
+
+    switch (entry->opcode) {
+    case 0x18:
+        *target = (uint16_t)(next + (int8_t)entry->operand);
+        return FLOW_JUMP;
+    case 0xC3:
+        *target = entry->operand;
+        return FLOW_JUMP;
+    case 0xCD:
+        *target = entry->operand;
+        return FLOW_CALL;
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+        *target = entry->opcode & 0x38;
+        return FLOW_CALL;
+    case 0x20: case 0x28: case 0x30: case 0x38:
+        *target = (uint16_t)(next + (int8_t)entry->operand);
+        return FLOW_BRANCH;
+    case 0xC2: case 0xCA: case 0xD2: case 0xDA:
+    case 0xC4: case 0xCC: case 0xD4: case 0xDC:
+        *target = entry->operand;
+        return FLOW_BRANCH;
+    case 0xC9: case 0xD9: case 0xE9:
+        return FLOW_RETURN;
+    case 0xC0: case 0xC8: case 0xD0: case 0xD8:
+        return FLOW_RETURN_COND;
+    case 0x10: case 0x76: case 0xF3: case 0xFB:
+        return FLOW_STOP;
+    case 0xD3: case 0xDB: case 0xDD: case 0xE3: case 0xE4:
+    case 0xEB: case 0xEC: case 0xED: case 0xF4: case 0xFC: case 0xFD:
+        return FLOW_ILLEGAL;
+    default:
+        return FLOW_NEXT;
+    }
+}
+
+// cycles the instruction adds when its branch is taken
+uint8_t decode_taken_cycles(uint8_t opcode) {
+    switch (opcode) {
+    case 0x20: case 0x28: case 0x30: case 0x38: // JR cc
+    case 0xC2: case 0xCA: case 0xD2: case 0xDA: // JP cc
+        return 1;
+    case 0xC4: case 0xCC: case 0xD4: case 0xDC: // CALL cc
+    case 0xC0: case 0xC8: case 0xD0: case 0xD8: // RET cc
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+// stores, read-modify-write and pushes; CALL and RST push too but end the block anyway
+bool decode_writes_memory(uint8_t opcode, uint8_t cb) {
+    if (opcode >= 0x70 && opcode <= 0x77 && opcode != 0x76) {
+        return true;
+    }
+
+    switch (opcode) {
+    case 0x02: case 0x12: case 0x22: case 0x32:
+    case 0x34: case 0x35: case 0x36: case 0x08:
+    case 0xC5: case 0xD5: case 0xE5: case 0xF5:
+    case 0xE0: case 0xE2: case 0xEA:
+        return true;
+    case 0xCB:
+        return (cb & 0x07) == 0x06 && (cb & 0xC0) != 0x40; // (HL) forms except BIT
+    default:
+        return false;
+    }
+}
+
+// the loop at pc changed state from one pass to the next, keep it as ordinary (maybe fused) code
+void decode_reject_idle(gb_instance *gb, uint16_t pc) {
+#ifdef GB_FUSION
+    decoded_instruction *entry = decode_slot(gb, pc);
+
+    if (entry != NULL && entry->fused == FUSED_IDLE_LOOP) {
+        entry->fused_operand = 0;
+        entry->fused = decode_fuse(gb, pc, &entry->fused_operand, false);
+    }
+#else
+    (void)gb;
+    (void)pc;
+#endif
+}
+
+// an instruction is at most 3 bytes long, so a write can only hit the two entries before it
+void decode_invalidate_wram(gb_instance *gb, uint16_t addr) {
+    uint16_t offset = addr - 0xC000;
+
+    for (int i = 0; i < 3 && offset >= i; i++) {
+        gb->decode.wram[offset - i].length = 0;
+    }
+}
+
+// D000-DFFF now shows another WRAM bank, returns false when nothing there was decoded
+bool decode_invalidate_wram_bank(gb_instance *gb) {
+    bool decoded = false;
+
+    for (int page = 0x10; page < 0x20; page++) {
+        decoded |= gb->decode.wram_pages[page] != 0;
+        gb->decode.wram_pages[page] = 0;
+    }
+
+    if (decoded) {
+        memset(&gb->decode.wram[0x1000], 0, 0x1000 * sizeof(decoded_instruction));
+        decode_invalidate_wram(gb, 0xD000); // instructions at CFFE/CFFF running into the bank
+    }
+    return decoded;
+}
+
+void decode_invalidate_hram(gb_instance *gb, uint16_t addr) {
+    uint16_t offset = addr - 0xFF80;
+
+    for (int i = 0; i < 3 && offset >= i; i++) {
+        gb->decode.hram[offset - i].length = 0;
+    }
+}
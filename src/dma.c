@@ -0,0 +1,201 @@
+#include "dma.h"
+#include "gb.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// the video bus is 8000-9FFF, everything else below FE00 is the external bus
+static inline bool dma_video_bus(uint16_t addr) {
+    return addr >= 0x8000 && addr <= 0x9FFF;
+}
+
+#define LCD_LINE_CYCLES 114
+#define LCD_VISIBLE_LINES 144
+#define LCD_HBLANK_START 63 // mode 2 and mode 3, mode 3 really varies with the sprites on the line
+
+// a DMA's own read of a source byte, never blocked by an OAM DMA lock
+static uint8_t dma_fetch(gb_instance *gb, uint16_t addr) {
+    if (addr >= 0xE000) { // sources past DFFF read the WRAM echo
+        addr -= 0x2000;
+    }
+
+    if (addr >= 0xC000) {
+        return *bus_wram(&gb->bus, addr);
+    }
+    if (dma_video_bus(addr)) {
+        return *bus_vram(&gb->bus, addr);
+    }
+    return cart_mem_read(gb, addr);
+}
+
+// move every byte that is due by the current cycle
+static void oam_dma_catch_up(gb_instance *gb) {
+    oam_dma_state *dma = &gb->oam_dma;
+
+    while (dma->index < OAM_DMA_LENGTH && dma->start + dma->index <= gb->cpu.cycles) {
+        dma->value = dma_fetch(gb, dma->source + dma->index);
+        gb->bus.oam[dma->index++] = dma->value;
+    }
+}
+
+// take the source's bus out of the map, so the CPU's accesses there reach oam_dma_conflict
+static void oam_dma_lock(gb_instance *gb) {
+    bus_map_reset(gb);
+    if (dma_video_bus(gb->oam_dma.source)) {
+        bus_unmap(gb, 0x8000, 0x9FFF);
+    } else {
+        bus_unmap(gb, 0x0000, 0x7FFF);
+        bus_unmap(gb, 0xC000, 0xDFFF);
+    }
+}
+
+static void oam_dma_event(gb_instance *gb, uint64_t when) {
+    oam_dma_state *dma = &gb->oam_dma;
+
+    (void)when;
+    if (!dma->active) {
+        dma->active = true;
+        oam_dma_lock(gb);
+    }
+
+    oam_dma_catch_up(gb);
+    if (dma->index < OAM_DMA_LENGTH) {
+        sched_add(gb, SCHED_OAM_DMA, dma->start + dma->index);
+        return ;
+    }
+
+    dma->active = false;
+    bus_map_reset(gb);
+}
+
+static void oam_dma_write(gb_instance *gb, uint16_t addr, uint8_t data) {
+    oam_dma_state *dma = &gb->oam_dma;
+    const uint8_t *page = gb->map.read[data];
+
+    (void)addr;
+    dma->source = (uint16_t)data << 8;
+
+    if (gb->accuracy == GB_ACCURACY_FAST) {
+        if (page != NULL) {
+            memcpy(gb->bus.oam, page, OAM_DMA_LENGTH);
+        } else {
+            for (uint8_t i = 0; i < OAM_DMA_LENGTH; i++) {
+                gb->bus.oam[i] = dma_fetch(gb, dma->source + i);
+            }
+        }
+        return ;
+    }
+
+    // a restart keeps the CPU locked out, the new transfer takes over after its setup cycle
+    if (dma->active) {
+        oam_dma_lock(gb);
+    }
+    dma->index = 0;
+    dma->start = gb->cpu.cycles + 1;
+    sched_add(gb, SCHED_OAM_DMA, dma->start);
+}
+
+// one 16-byte block into the current VRAM bank; a block never crosses a page
+static void hdma_copy_block(gb_instance *gb) {
+    hdma_state *hdma = &gb->hdma;
+    const uint8_t *page = gb->map.read[hdma->source >> 8];
+    uint8_t *dest = bus_vram(&gb->bus, hdma->dest);
+
+    if (page != NULL) {
+        memcpy(dest, page + (hdma->source & 0xFF), HDMA_BLOCK);
+    } else {
+        for (uint8_t i = 0; i < HDMA_BLOCK; i++) {
+            dest[i] = dma_fetch(gb, hdma->source + i);
+        }
+    }
+
+    hdma->source += HDMA_BLOCK;
+    hdma->dest = 0x8000 | ((hdma->dest + HDMA_BLOCK) & 0x1FF0);
+    hdma->remaining--;
+}
+
+// the first HBlank starting at or after cycle, or cycle itself when it is inside one
+static uint64_t hdma_hblank_from(uint64_t cycle) {
+    uint64_t frame_pos = cycle % GB_CYCLES_PER_FRAME;
+    uint64_t line = frame_pos / LCD_LINE_CYCLES;
+    uint64_t pos = frame_pos % LCD_LINE_CYCLES;
+
+    if (line >= LCD_VISIBLE_LINES) {
+        return cycle - frame_pos + GB_CYCLES_PER_FRAME + LCD_HBLANK_START;
+    }
+    return pos >= LCD_HBLANK_START ? cycle : cycle - pos + LCD_HBLANK_START;
+}
+
+static void hdma_event(gb_instance *gb, uint64_t when) {
+    hdma_state *hdma = &gb->hdma;
+    uint64_t next_line = when - when % GB_CYCLES_PER_FRAME % LCD_LINE_CYCLES + LCD_LINE_CYCLES;
+
+    hdma_copy_block(gb);
+    gb->cpu.cycles += HDMA_BLOCK_CYCLES;
+
+    if (hdma->remaining == 0) {
+        hdma->active = false;
+        return ;
+    }
+    sched_add(gb, SCHED_HDMA, hdma_hblank_from(next_line));
+}
+
+// bit 7 clear while a transfer is armed, the low bits are the blocks left minus one (0xFF when done)
+static uint8_t hdma_read(gb_instance *gb, uint16_t addr) {
+    hdma_state *hdma = &gb->hdma;
+
+    (void)addr;
+    return (hdma->active ? 0x00 : 0x80) | ((hdma->remaining - 1) & 0x7F);
+}
+
+static void hdma_write(gb_instance *gb, uint16_t addr, uint8_t data) {
+    hdma_state *hdma = &gb->hdma;
+    uint8_t *reg = &gb->io.value[io_index(0xFF51)];
+
+    (void)addr;
+    if (hdma->active && !(data & 0x80)) {
+        hdma->active = false;
+        sched_cancel(gb, SCHED_HDMA);
+        return ;
+    }
+
+    hdma->source = (uint16_t)(reg[0] << 8 | reg[1]) & 0xFFF0;
+    hdma->dest = 0x8000 | ((uint16_t)(reg[2] << 8 | reg[3]) & 0x1FF0);
+    hdma->remaining = (data & 0x7F) + 1;
+
+    if (data & 0x80) {
+        hdma->active = true;
+        sched_add(gb, SCHED_HDMA, hdma_hblank_from(gb->cpu.cycles));
+        return ;
+    }
+
+    // general purpose: everything now, the CPU waits for all of it
+    gb->cpu.cycles += (uint64_t)hdma->remaining * HDMA_BLOCK_CYCLES;
+    while (hdma->remaining > 0) {
+        hdma_copy_block(gb);
+    }
+}
+
+void dma_init(gb_instance *gb) {
+    memset(&gb->oam_dma, 0, sizeof(oam_dma_state));
+    io_set_handler(gb, 0xFF46, NULL, oam_dma_write);
+    sched_set_handler(gb, SCHED_OAM_DMA, oam_dma_event);
+
+    memset(&gb->hdma, 0, sizeof(hdma_state));
+    if (gb->cgb) {
+        io_set_handler(gb, 0xFF55, hdma_read, hdma_write);
+        sched_set_handler(gb, SCHED_HDMA, hdma_event);
+    }
+}
+
+bool oam_dma_locks(gb_instance *gb, uint16_t addr) {
+    return gb->oam_dma.active && dma_video_bus(addr) == dma_video_bus(gb->oam_dma.source);
+}
+
+bool oam_dma_conflict(gb_instance *gb, uint16_t addr) {
+    if (addr >= 0xFE00) {
+        return addr <= 0xFE9F;
+    }
+    return dma_video_bus(addr) == dma_video_bus(gb->oam_dma.source);
+}
@@ -0,0 +1,155 @@
+#include "gb.h"
+#include "instructions.h"
+
+#include <stdlib.h>
+
+static void gb_reset(gb_instance *gb) {
+    gb->idle_skip = true;
+    gb->cgb = cart_cgb(gb);
+
+    io_init(gb);
+    mem_init(gb);
+    cpu_init(gb);
+    decode_init(gb);
+    sched_init(gb);
+    dma_init(gb);
+    interrupt_init(gb);
+#if GB_TRACE_LEVEL > TRACE_LEVEL_OFF
+    trace_set_level(gb, GB_TRACE_LEVEL);
+#endif
+
+    gb->run_deadline = 0;
+    gb->frame_deadline = GB_CYCLES_PER_FRAME;
+}
+
+gb_instance *gb_create(const char *cart_path) {
+    gb_instance *gb = (gb_instance *)calloc(1, sizeof(gb_instance));
+    if (gb == NULL) {
+        return NULL;
+    }
+
+    if (cart_init(gb, cart_path)) {
+        free(gb);
+        return NULL;
+    }
+
+    gb_reset(gb);
+    return gb;
+}
+
+gb_instance *gb_create_rom(const uint8_t *rom_data, uint32_t rom_size) {
+    gb_instance *gb = (gb_instance *)calloc(1, sizeof(gb_instance));
+    if (gb == NULL) {
+        return NULL;
+    }
+
+    if (cart_init_rom(gb, rom_data, rom_size)) {
+        free(gb);
+        return NULL;
+    }
+
+    gb_reset(gb);
+    return gb;
+}
+
+void gb_destroy(gb_instance *gb) {
+    if (gb == NULL) {
+        return ;
+    }
+
+#ifdef GB_PROFILE
+    hotspot_stop(gb);
+    callstack_stop(gb);
+#endif
+#if GB_TRACE_LEVEL > TRACE_LEVEL_OFF
+    trace_remove_crash_handler(gb);
+#endif
+    jit_free(gb);
+    decode_free(gb);
+    cart_free(gb);
+    free(gb);
+}
+
+// the decoded ROM is dropped since idle loops are only marked in fast mode
+void gb_set_accuracy(gb_instance *gb, gb_accuracy accuracy) {
+    if (gb->accuracy != accuracy) {
+        gb->accuracy = accuracy;
+        decode_drop_rom(gb);
+    }
+}
+
+static uint32_t gb_run_until(gb_instance *gb, uint64_t deadline) {
+    emu_cpu *cpu = &gb->cpu;
+    uint64_t start = cpu->cycles;
+
+    gb->exit_requested = false;
+
+    /**
+     * The engines only check run_deadline, so it is pulled in to the next
+     * scheduled event: the engine returns, the event is serviced here and the
+     * engine picks up again. That cost is the same however many peripherals
+     * are scheduled.
+     */
+    while (cpu->cycles < deadline && !gb->exit_requested) {
+        if (cpu->cycles >= gb->next_event) {
+            sched_run(gb);
+            continue;
+        }
+
+        // IE & IF wakes the CPU even with IME off, it then just carries on after HALT
+        if (cpu->halted && gb->irq.active) {
+            cpu->halted = false;
+        }
+
+        if (gb->irq.pending) {
+            interrupt_service(gb);
+            continue;
+        }
+
+        gb->run_deadline = gb->next_event < deadline ? gb->next_event : deadline;
+
+        if (cpu->halted) {
+            cpu->cycles = gb_wake_cycle(gb);
+            continue;
+        }
+
+        if (gb->irq.deferred) {
+            interrupt_deferred_step(gb);
+            continue;
+        }
+
+        if (gb->accuracy == GB_ACCURACY_PRECISE) {
+            instructions_run_precise(gb);
+        } else if (gb->rec != NULL) {
+            staticrec_run(gb);
+#ifdef GB_HAVE_JIT
+        } else if (gb->jit != NULL) {
+            jit_run(gb);
+#endif
+        } else {
+            instructions_run(gb);
+        }
+    }
+
+    return (uint32_t)(cpu->cycles - start);
+}
+
+uint32_t gb_run_cycles(gb_instance *gb, uint32_t cycles) {
+    return gb_run_until(gb, gb->cpu.cycles + cycles);
+}
+
+uint32_t gb_run_frame(gb_instance *gb) {
+    uint32_t ran = gb_run_until(gb, gb->frame_deadline);
+
+    // an early exit leaves the deadline alone so the next call finishes the frame
+    while (gb->cpu.cycles >= gb->frame_deadline) {
+        gb->frame_deadline += GB_CYCLES_PER_FRAME;
+    }
+
+    return ran;
+}
+
+void gb_request_exit(gb_instance *gb) {
+    gb->exit_requested = true;
+    gb->run_deadline = 0;
+}
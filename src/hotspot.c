@@ -0,0 +1,219 @@
+#ifdef GB_PROFILE
+
+#include "hotspot.h"
+#include "gb.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOTSPOT_FREE 0xFFFFFFFFu
+#define HOTSPOT_INITIAL_CAPACITY 1024
+
+static uint32_t hotspot_key(gb_instance *gb, uint16_t pc) {
+    if (pc <= 0x3FFF) {
+        return pc;
+    }
+    if (pc <= 0x7FFF) {
+        return (uint32_t)gb->cart.rom_bank << 16 | pc;
+    }
+    return (uint32_t)HOTSPOT_RAM_BANK << 16 | pc;
+}
+
+static uint32_t hotspot_slot(const hotspot_data *h, uint32_t key) {
+    uint32_t mask = h->capacity - 1;
+    uint32_t i = (key * 2654435761u) & mask;
+
+    while (h->keys[i] != HOTSPOT_FREE && h->keys[i] != key) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static bool hotspot_resize(hotspot_data *h, uint32_t capacity) {
+    uint32_t *keys = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    uint32_t *hits = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+    if (keys == NULL || hits == NULL) {
+        free(keys);
+        free(hits);
+        return false;
+    }
+    memset(keys, 0xFF, capacity * sizeof(uint32_t));
+
+    hotspot_data old = *h;
+    h->keys = keys;
+    h->hits = hits;
+    h->capacity = capacity;
+    for (uint32_t i = 0; i < old.capacity; i++) {
+        if (old.keys[i] != HOTSPOT_FREE) {
+            uint32_t slot = hotspot_slot(h, old.keys[i]);
+            h->keys[slot] = old.keys[i];
+            h->hits[slot] = old.hits[i];
+        }
+    }
+
+    free(old.keys);
+    free(old.hits);
+    return true;
+}
+
+static void hotspot_sample(gb_instance *gb, uint64_t when) {
+    hotspot_data *h = &gb->hotspot;
+    uint32_t key = hotspot_key(gb, gb->cpu.reg.pc);
+
+    sched_add(gb, SCHED_HOTSPOT, when + h->interval);
+
+    // keep the table at most 3/4 full
+    if ((h->used + 1) * 4 > h->capacity * 3 && !hotspot_resize(h, h->capacity * 2)) {
+        return ;
+    }
+
+    uint32_t slot = hotspot_slot(h, key);
+    if (h->keys[slot] == HOTSPOT_FREE) {
+        h->keys[slot] = key;
+        h->used++;
+    }
+    h->hits[slot]++;
+    h->samples++;
+}
+
+void hotspot_start(gb_instance *gb, uint32_t interval, bool coverage) {
+    hotspot_data *h = &gb->hotspot;
+
+    hotspot_stop(gb);
+    if (interval == 0 || !hotspot_resize(h, HOTSPOT_INITIAL_CAPACITY)) {
+        return ;
+    }
+
+    if (coverage) {
+        h->coverage = (uint8_t *)calloc((gb->cart.rom_size + 7) / 8, 1);
+    }
+
+    h->interval = interval;
+    sched_set_handler(gb, SCHED_HOTSPOT, hotspot_sample);
+    sched_add(gb, SCHED_HOTSPOT, gb->cpu.cycles + interval);
+}
+
+void hotspot_stop(gb_instance *gb) {
+    hotspot_data *h = &gb->hotspot;
+
+    if (h->interval != 0) {
+        sched_cancel(gb, SCHED_HOTSPOT);
+    }
+    free(h->keys);
+    free(h->hits);
+    free(h->coverage);
+    memset(h, 0, sizeof(*h));
+}
+
+void hotspot_mark(gb_instance *gb, uint16_t pc) {
+    hotspot_data *h = &gb->hotspot;
+
+    if (pc >= 0x8000) {
+        h->ram_coverage[(pc - 0x8000) >> 3] |= 1 << (pc & 7);
+        return ;
+    }
+
+    uint32_t offset = pc <= 0x3FFF ? pc : (uint32_t)gb->cart.rom_bank * 0x4000 + (pc - 0x4000);
+    if (offset < gb->cart.rom_size) {
+        h->coverage[offset >> 3] |= 1 << (offset & 7);
+    }
+}
+
+static int hotspot_compare(const void *a, const void *b) {
+    const hotspot_entry *x = (const hotspot_entry *)a;
+    const hotspot_entry *y = (const hotspot_entry *)b;
+
+    if (x->hits != y->hits) {
+        return x->hits < y->hits ? 1 : -1;
+    }
+    if (x->bank != y->bank) {
+        return x->bank < y->bank ? -1 : 1;
+    }
+    return x->addr < y->addr ? -1 : x->addr > y->addr;
+}
+
+uint32_t hotspot_top(gb_instance *gb, hotspot_entry *out, uint32_t max) {
+    hotspot_data *h = &gb->hotspot;
+    hotspot_entry *all;
+    uint32_t n = 0;
+
+    if (h->used == 0 || max == 0) {
+        return 0;
+    }
+    all = (hotspot_entry *)malloc(h->used * sizeof(hotspot_entry));
+    if (all == NULL) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < h->capacity; i++) {
+        if (h->keys[i] != HOTSPOT_FREE) {
+            all[n].bank = (uint16_t)(h->keys[i] >> 16);
+            all[n].addr = (uint16_t)h->keys[i];
+            all[n].hits = h->hits[i];
+            n++;
+        }
+    }
+    qsort(all, n, sizeof(hotspot_entry), hotspot_compare);
+
+    n = n < max ? n : max;
+    memcpy(out, all, n * sizeof(hotspot_entry));
+    free(all);
+    return n;
+}
+
+static uint32_t popcount_range(const uint8_t *bits, uint32_t first, uint32_t count) {
+    uint32_t set = 0;
+
+    for (uint32_t i = first; i < first + count; i++) {
+        set += (bits[i >> 3] >> (i & 7)) & 1;
+    }
+    return set;
+}
+
+double hotspot_bank_coverage(gb_instance *gb, uint16_t bank) {
+    hotspot_data *h = &gb->hotspot;
+    uint32_t first = (uint32_t)bank * 0x4000;
+
+    if (h->coverage == NULL || first >= gb->cart.rom_size) {
+        return 0.0;
+    }
+
+    uint32_t size = gb->cart.rom_size - first < 0x4000 ? gb->cart.rom_size - first : 0x4000;
+    return (double)popcount_range(h->coverage, first, size) / size;
+}
+
+int hotspot_write_report(gb_instance *gb, FILE *out, uint32_t top) {
+    hotspot_data *h = &gb->hotspot;
+    hotspot_entry *entries = (hotspot_entry *)malloc((top ? top : 1) * sizeof(hotspot_entry));
+    uint32_t n;
+
+    if (entries == NULL) {
+        return -1;
+    }
+    n = hotspot_top(gb, entries, top);
+
+    fprintf(out, "bank,addr,hits,share\n");
+    for (uint32_t i = 0; i < n; i++) {
+        if (entries[i].bank == HOTSPOT_RAM_BANK) {
+            fprintf(out, "ram,");
+        } else {
+            fprintf(out, "%u,", entries[i].bank);
+        }
+        fprintf(out, "0x%04X,%u,%.4f\n", entries[i].addr, entries[i].hits,
+                h->samples ? (double)entries[i].hits / h->samples : 0.0);
+    }
+    free(entries);
+
+    if (h->coverage != NULL) {
+        fprintf(out, "\nbank,covered_ratio\n");
+        for (uint32_t bank = 0; bank * 0x4000 < gb->cart.rom_size; bank++) {
+            fprintf(out, "%u,%.4f\n", bank, hotspot_bank_coverage(gb, (uint16_t)bank));
+        }
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+#endif
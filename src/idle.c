@@ -0,0 +1,60 @@
+#include "idle.h"
+#include "gb.h"
+#include "decode.h"
+#include "instructions.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// one pass over the loop body, stops when it branches back to loop, leaves it or the engine has to return
+static bool idle_pass(gb_instance *gb, uint16_t loop, uint16_t end) {
+    do {
+        instructions_step(gb);
+    } while (gb->cpu.reg.pc > loop && gb->cpu.reg.pc < end && gb->cpu.cycles < gb->run_deadline);
+
+    return gb->cpu.reg.pc == loop && gb->cpu.cycles < gb->run_deadline;
+}
+
+static bool idle_same(emu_cpu *a, emu_cpu *b) {
+    return a->reg.a == b->reg.a && a->reg.bc == b->reg.bc && a->reg.de == b->reg.de &&
+           a->reg.hl == b->reg.hl && a->reg.sp == b->reg.sp && flags_pack(a) == flags_pack(b);
+}
+
+void idle_loop_run(gb_instance *gb, uint16_t loop, uint16_t end) {
+    emu_cpu *cpu = &gb->cpu;
+
+    cpu->reg.pc = loop;
+    if (!idle_pass(gb, loop, end)) {
+        return ;
+    }
+
+    emu_cpu first = *cpu;
+    if (!idle_pass(gb, loop, end)) {
+        return ;
+    }
+
+    if (!idle_same(&first, cpu)) {
+        decode_reject_idle(gb, loop);
+        gb->idle.rejected++;
+        return ;
+    }
+
+    // memory only changes through events, so every pass until the next one is identical
+    uint64_t period = cpu->cycles - first.cycles;
+    uint64_t wake = gb->next_event < gb->run_deadline ? gb->next_event : gb->run_deadline;
+
+    if (wake > cpu->cycles + period) {
+        uint64_t skipped = (wake - cpu->cycles) / period * period;
+        cpu->cycles += skipped;
+        gb->idle.skips++;
+        gb->idle.skipped_cycles += skipped;
+    }
+}
+
+// toggling drops the decoded ROM, so loops already marked are decoded again
+void gb_set_idle_skip(gb_instance *gb, bool enable) {
+    if (gb->idle_skip != enable) {
+        gb->idle_skip = enable;
+        decode_drop_rom(gb);
+    }
+}
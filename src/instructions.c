@@ -1,1541 +1,2166 @@
 #include "instructions.h"
+#include "gb.h"
 #include "bus.h"
 #include "cpu.h"
+#include "decode.h"
+#include "interrupt.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
-static inline uint8_t read_d8(emu_cpu *cpu) {
-    uint8_t d8 = bus_read(cpu->reg.pc);
-    cpu->reg.pc++;
-    return d8;
+// immediates are pulled out when the instruction is fetched, pc already points past them
+static inline uint8_t read_d8(gb_instance *gb) {
+    return (uint8_t)gb->cpu.imm;
 }
 
-static inline uint16_t read_d16(emu_cpu *cpu) {
-    uint8_t low = bus_read(cpu->reg.pc);
-    cpu->reg.pc++;
-    uint8_t high = bus_read(cpu->reg.pc);
-    cpu->reg.pc++;
-    uint16_t d16 = (uint16_t)low | ((uint16_t)high << 8);
-    return d16;
+static inline uint16_t read_d16(gb_instance *gb) {
+    return gb->cpu.imm;
 }
 
-static inline void cp_8(uint8_t v1, uint8_t v2) {
-    set_N(1);
-    set_Z(v1 == v2);
-    set_H((v1 & 0x0F) < (v2 & 0x0F));
-    set_C(v1 < v2);
+/**
+ * Handler memory accesses. Each handler adds its cycles so that cpu.cycles
+ * sits on the M-cycle of an access when it is made. The precise build (see
+ * instructions_precise.c) runs the events due by then before every access.
+ * The fast build only catches peripherals up between instructions, and the
+ * split additions fold into the same instruction total.
+ */
+#ifdef GB_TIMING_PRECISE
+static inline void mem_sync(gb_instance *gb) {
+    if (gb->cpu.cycles >= gb->next_event) {
+        sched_run(gb);
+    }
+}
+#else
+static inline void mem_sync(gb_instance *gb) {
+    (void)gb;
+}
+#endif
+
+static inline uint8_t mem_read(gb_instance *gb, uint16_t addr) {
+    mem_sync(gb);
+    return bus_read(gb, addr);
+}
+
+static inline void mem_write(gb_instance *gb, uint16_t addr, uint8_t data) {
+    mem_sync(gb);
+    bus_write(gb, addr, data);
+}
+
+/**
+ * 16-bit accesses, one byte per M-cycle, starting at the current cycle. The
+ * precise build makes them as two timed byte accesses in the order the CPU
+ * does. With nothing to sync in between, the fast build does a single
+ * bus_read16/bus_write16.
+ */
+#ifdef GB_TIMING_PRECISE
+static inline uint16_t mem_read16(gb_instance *gb, uint16_t addr) {
+    uint16_t u16 = mem_read(gb, addr);
+    gb->cpu.cycles += 1;
+    u16 |= (uint16_t)mem_read(gb, addr + 1) << 8;
+    gb->cpu.cycles += 1;
+    return u16;
 }
 
-static inline void push_16(emu_cpu *cpu, uint16_t v) {
-    cpu->reg.sp -= 2;
-    bus_write(cpu->reg.sp + 1, (uint8_t)(v >> 8) & 0xFF);
-    bus_write(cpu->reg.sp, (uint8_t)(v & 0xFF));
+static inline void mem_write16(gb_instance *gb, uint16_t addr, uint16_t data, bool high_first) {
+    mem_write(gb, high_first ? addr + 1 : addr, high_first ? (uint8_t)(data >> 8) : (uint8_t)data);
+    gb->cpu.cycles += 1;
+    mem_write(gb, high_first ? addr : addr + 1, high_first ? (uint8_t)data : (uint8_t)(data >> 8));
+    gb->cpu.cycles += 1;
+}
+#else
+static inline uint16_t mem_read16(gb_instance *gb, uint16_t addr) {
+    uint16_t u16 = bus_read16(gb, addr);
+    gb->cpu.cycles += 2;
+    return u16;
 }
 
-static inline uint16_t pop_16(emu_cpu *cpu) {
-    uint16_t u16 = (uint16_t)bus_read(cpu->reg.sp) | ((uint16_t)bus_read(cpu->reg.sp + 1) << 8);
-    cpu->reg.sp += 2;
+static inline void mem_write16(gb_instance *gb, uint16_t addr, uint16_t data, bool high_first) {
+    (void)high_first;
+    bus_write16(gb, addr, data);
+    gb->cpu.cycles += 2;
+}
+#endif
+
+static inline void cp_8(gb_instance *gb, uint8_t v1, uint8_t v2) {
+    uint16_t r = (uint16_t)v1 - v2;
+    flags_znhc(&gb->cpu, (uint8_t)r, 1, v1 ^ v2 ^ r, r);
+}
+
+// two M-cycles, high byte first
+static inline void push_16(gb_instance *gb, uint16_t v) {
+    gb->cpu.reg.sp -= 2;
+    mem_write16(gb, gb->cpu.reg.sp, v, true);
+}
+
+// two M-cycles, low byte first
+static inline uint16_t pop_16(gb_instance *gb) {
+    uint16_t u16 = mem_read16(gb, gb->cpu.reg.sp);
+    gb->cpu.reg.sp += 2;
     return u16;
 }
 
-static inline void inc_8(emu_cpu *cpu, uint8_t *v) {
-    (*v)++;
-    set_Z(*v == 0);
-    set_N(0);
-    set_H((*v & 0x0F) == 0x00);
+static inline void inc_8(gb_instance *gb, uint8_t *v) {
+    uint8_t r = *v + 1;
+    flags_znh(&gb->cpu, r, 0, *v ^ 1 ^ r);
+    *v = r;
 }
 
-static inline void dec_8(emu_cpu *cpu, uint8_t *v) {
-    (*v)--;
-    set_Z(*v == 0);
-    set_N(1);
-    set_H((*v & 0x0F) == 0x0F);
+static inline void dec_8(gb_instance *gb, uint8_t *v) {
+    uint8_t r = *v - 1;
+    flags_znh(&gb->cpu, r, 1, *v ^ 1 ^ r);
+    *v = r;
 }
 
-static inline uint8_t add_8(uint16_t v1, uint16_t v2) {
-    uint8_t r = (uint8_t)(v1 + v2); 
-    set_Z(r == 0);
-    set_N(0);
-    set_H(((v1 & 0x0F) + (v2 & 0x0F)) > 0x0F);
-    set_C((v1 + v2) > 0xFF);
+static inline uint8_t add_8(gb_instance *gb, uint16_t v1, uint16_t v2) {
+    uint16_t r = v1 + v2;
+    flags_znhc(&gb->cpu, (uint8_t)r, 0, v1 ^ v2 ^ r, r);
+    return (uint8_t)r;
+}
+
+static inline uint16_t add_16(gb_instance *gb, uint32_t v1, uint32_t v2) {
+    uint32_t r = v1 + v2;
+    flags_nhc(&gb->cpu, 0, (uint16_t)((v1 ^ v2 ^ r) >> 8), (uint16_t)(r >> 8));
+    return (uint16_t)r;
+}
+
+static inline uint8_t adc_8(gb_instance *gb, uint16_t v1, uint16_t v2) {
+    uint16_t r = v1 + v2 + flag_C(&gb->cpu);
+    flags_znhc(&gb->cpu, (uint8_t)r, 0, v1 ^ v2 ^ r, r);
+    return (uint8_t)r;
+}
+
+// the borrow lands in bit 8 of the wrapped 16-bit result, same as a carry
+static inline uint8_t sub_8(gb_instance *gb, uint16_t v1, uint16_t v2) {
+    uint16_t r = v1 - v2;
+    flags_znhc(&gb->cpu, (uint8_t)r, 1, v1 ^ v2 ^ r, r);
+    return (uint8_t)r;
+}
+
+static inline uint8_t sbc_8(gb_instance *gb, uint16_t v1, uint16_t v2) {
+    uint16_t r = v1 - v2 - flag_C(&gb->cpu);
+    flags_znhc(&gb->cpu, (uint8_t)r, 1, v1 ^ v2 ^ r, r);
+    return (uint8_t)r;
+}
+
+static inline uint8_t and_8(gb_instance *gb, uint8_t v1, uint8_t v2) {
+    uint8_t r = v1 & v2;
+    flags_znhc(&gb->cpu, r, 0, 0x10, 0);
     return r;
 }
 
-static inline uint16_t add_16(uint32_t v1, uint32_t v2) {
-    uint16_t r = (uint16_t)(v1 + v2);
-    set_N(0);
-    set_H(((v1 & 0x0FFF) + (v2 & 0x0FFF)) > 0x0FFF);
-    set_C((v1 + v2) > 0xFFFF);
+static inline uint8_t xor_8(gb_instance *gb, uint8_t v1, uint8_t v2) {
+    uint8_t r = v1 ^ v2;
+    flags_znhc(&gb->cpu, r, 0, 0, 0);
     return r;
 }
 
-static inline uint8_t adc_8(uint16_t v1, uint16_t v2) {
-    uint16_t c = flag_C();
-    uint8_t  r = (uint8_t)(v1 + v2 + c);
-    set_Z(r == 0);
-    set_N(0);
-    set_H(((v1 & 0x0F) + (v2 & 0x0F) + c) > 0x0F);
-    set_C((v1 + v2 + c) > 0xFF);
+static inline uint8_t or_8(gb_instance *gb, uint8_t v1, uint8_t v2) {
+    uint8_t r = v1 | v2;
+    flags_znhc(&gb->cpu, r, 0, 0, 0);
     return r;
 }
 
-static inline uint8_t sub_8(uint16_t v1, uint16_t v2) {
-    uint8_t r = (uint8_t)(v1 - v2);
-    set_Z(r == 0);
-    set_N(1);
-    set_H((v1 & 0x0F) < (v2 & 0x0F));
-    set_C(v1 < v2);
+// rotates and shifts: C comes out of bit 8 of the value handed to the flag helpers
+static inline uint8_t rlc_8(gb_instance *gb, uint8_t v) {
+    uint8_t r = (uint8_t)(v << 1 | v >> 7);
+    flags_znhc(&gb->cpu, r, 0, 0, (uint16_t)v << 1);
     return r;
 }
 
-static inline uint8_t sbc_8(uint16_t v1, uint16_t v2) {
-    uint16_t c = flag_C();
-    uint8_t  r = (uint8_t)(v1 - v2 - c);
-    set_Z(r == 0);
-    set_N(1);
-    set_H((v1 & 0x0F) < ((v2 & 0x0F) + c));
-    set_C(v1 < (v2 + c));
+static inline uint8_t rrc_8(gb_instance *gb, uint8_t v) {
+    uint8_t r = (uint8_t)(v >> 1 | v << 7);
+    flags_znhc(&gb->cpu, r, 0, 0, (uint16_t)(v & 1) << 8);
     return r;
 }
 
-static inline uint8_t and_8(uint8_t v1, uint8_t v2) {
-    uint8_t r = v1 & v2;
-    set_Z(r == 0);
-    set_N(0);
-    set_H(1);
-    set_C(0);
+static inline uint8_t rl_8(gb_instance *gb, uint8_t v) {
+    uint8_t r = (uint8_t)(v << 1 | flag_C(&gb->cpu));
+    flags_znhc(&gb->cpu, r, 0, 0, (uint16_t)v << 1);
     return r;
 }
 
-static inline uint8_t xor_8(uint8_t v1, uint8_t v2) {
-    uint8_t r = v1 ^ v2;
-    set_Z(r == 0);
-    set_N(0);
-    set_H(0);
-    set_C(0);
+static inline uint8_t rr_8(gb_instance *gb, uint8_t v) {
+    uint8_t r = (uint8_t)(v >> 1 | flag_C(&gb->cpu) << 7);
+    flags_znhc(&gb->cpu, r, 0, 0, (uint16_t)(v & 1) << 8);
     return r;
 }
 
-static inline uint8_t or_8(uint8_t v1, uint8_t v2) {
-    uint8_t r = v1 | v2;
-    set_Z(r == 0);
-    set_N(0);
-    set_H(0);
-    set_C(0);
+static inline uint8_t sla_8(gb_instance *gb, uint8_t v) {
+    uint8_t r = (uint8_t)(v << 1);
+    flags_znhc(&gb->cpu, r, 0, 0, (uint16_t)v << 1);
+    return r;
+}
+
+static inline uint8_t sra_8(gb_instance *gb, uint8_t v) {
+    uint8_t r = (uint8_t)(v >> 1 | (v & 0x80));
+    flags_znhc(&gb->cpu, r, 0, 0, (uint16_t)(v & 1) << 8);
     return r;
 }
 
-static inline void x00_nop(emu_cpu *cpu) {
-    cpu->cycles += 1;
+static inline uint8_t swap_8(gb_instance *gb, uint8_t v) {
+    uint8_t r = (uint8_t)(v << 4 | v >> 4);
+    flags_znhc(&gb->cpu, r, 0, 0, 0);
+    return r;
+}
+
+static inline uint8_t srl_8(gb_instance *gb, uint8_t v) {
+    uint8_t r = v >> 1;
+    flags_znhc(&gb->cpu, r, 0, 0, (uint16_t)(v & 1) << 8);
+    return r;
+}
+
+static inline void bit_8(gb_instance *gb, uint8_t v, uint8_t mask) {
+    flags_znh(&gb->cpu, v & mask, 0, 0x10);
+}
+
+static inline void x00_nop(gb_instance *gb) {
+    gb->cpu.cycles += 1;
 }
 
-static inline void x01_ld_bc_d16(emu_cpu *cpu) {
-    set_BC(read_d16(cpu));
-    cpu->cycles += 3;
+static inline void x01_ld_bc_d16(gb_instance *gb) {
+    gb->cpu.reg.bc = read_d16(gb);
+    gb->cpu.cycles += 3;
 }
 
-static inline void x02_ld_mbc_a(emu_cpu *cpu) {
-    bus_write(get_BC(), cpu->reg.a);
-    cpu->cycles += 2;
+static inline void x02_ld_mbc_a(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.bc, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x03_inc_bc(emu_cpu *cpu) {
-    set_BC(get_BC() + 1);
-    cpu->cycles += 2;
+static inline void x03_inc_bc(gb_instance *gb) {
+    gb->cpu.reg.bc++;
+    gb->cpu.cycles += 2;
 }
 
-static inline void x04_inc_b(emu_cpu *cpu) {
-    inc_8(cpu, &cpu->reg.b);
-    cpu->cycles += 1;
+static inline void x04_inc_b(gb_instance *gb) {
+    inc_8(gb, &gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x05_dec_b(emu_cpu *cpu) {
-    dec_8(cpu, &cpu->reg.b);
-    cpu->cycles += 1;
+static inline void x05_dec_b(gb_instance *gb) {
+    dec_8(gb, &gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x06_ld_b_d8(emu_cpu *cpu) {
-    cpu->reg.b = read_d8(cpu);
-    cpu->cycles += 2;
+static inline void x06_ld_b_d8(gb_instance *gb) {
+    gb->cpu.reg.b = read_d8(gb);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x08_ld_a16_sp(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->cycles += 2;
-    bus_write(a16, (uint8_t)(cpu->reg.sp & 0xFF));
-    cpu->cycles += 1;
-    bus_write(a16 + 1, (uint8_t)(cpu->reg.sp >> 8));
-    cpu->cycles += 2;
+static inline void x07_rlca(gb_instance *gb) {
+    gb->cpu.reg.a = rlc_8(gb, gb->cpu.reg.a);
+    set_Z(&gb->cpu, 0);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x09_add_hl_bc(emu_cpu *cpu) {
-    set_HL(add_16(get_HL(), get_BC()));
-    cpu->cycles += 2;
+static inline void x08_ld_a16_sp(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.cycles += 3;
+    mem_write16(gb, a16, gb->cpu.reg.sp, false);
 }
 
-static inline void x0a_ld_a_mbc(emu_cpu *cpu) {
-    cpu->reg.a = bus_read(get_BC());
-    cpu->cycles += 2;
+static inline void x09_add_hl_bc(gb_instance *gb) {
+    gb->cpu.reg.hl = add_16(gb, gb->cpu.reg.hl, gb->cpu.reg.bc);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x0b_dec_bc(emu_cpu *cpu) {
-    set_BC(get_BC() - 1);
-    cpu->cycles += 2;
+static inline void x0a_ld_a_mbc(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = mem_read(gb, gb->cpu.reg.bc);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x0c_inc_c(emu_cpu *cpu) {
-    inc_8(cpu, &cpu->reg.c);
-    cpu->cycles += 1;
+static inline void x0b_dec_bc(gb_instance *gb) {
+    gb->cpu.reg.bc--;
+    gb->cpu.cycles += 2;
 }
 
-static inline void x0d_dec_c(emu_cpu *cpu) {
-    dec_8(cpu, &cpu->reg.c);
-    cpu->cycles += 1;
+static inline void x0c_inc_c(gb_instance *gb) {
+    inc_8(gb, &gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x0e_ld_c_d8(emu_cpu *cpu) {
-    cpu->reg.c = read_d8(cpu);
-    cpu->cycles += 2;
+static inline void x0d_dec_c(gb_instance *gb) {
+    dec_8(gb, &gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x11_ld_de_d16(emu_cpu *cpu) {
-    set_DE(read_d16(cpu));
-    cpu->cycles += 3;
+static inline void x0e_ld_c_d8(gb_instance *gb) {
+    gb->cpu.reg.c = read_d8(gb);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x12_ld_mde_a(emu_cpu *cpu) {
-    bus_write(get_DE(), cpu->reg.a);
-    cpu->cycles += 2;
+static inline void x0f_rrca(gb_instance *gb) {
+    gb->cpu.reg.a = rrc_8(gb, gb->cpu.reg.a);
+    set_Z(&gb->cpu, 0);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x13_inc_de(emu_cpu *cpu) {
-    set_DE(get_DE() + 1);
-    cpu->cycles += 2;
+// STOP waits for a button press; without a joypad yet it sleeps like HALT
+static inline void x10_stop(gb_instance *gb) {
+    gb->cpu.halted = true;
+    gb->cpu.cycles += 1;
+    gb_break_engine(gb);
 }
 
-static inline void x14_inc_d(emu_cpu *cpu) {
-    inc_8(cpu, &cpu->reg.d);
-    cpu->cycles += 1;
+static inline void x11_ld_de_d16(gb_instance *gb) {
+    gb->cpu.reg.de = read_d16(gb);
+    gb->cpu.cycles += 3;
 }
 
-static inline void x15_dec_d(emu_cpu *cpu) {
-    dec_8(cpu, &cpu->reg.d);
-    cpu->cycles += 1;
+static inline void x12_ld_mde_a(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.de, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x16_ld_d_d8(emu_cpu *cpu) {
-    cpu->reg.d = read_d8(cpu);
-    cpu->cycles += 2;
+static inline void x13_inc_de(gb_instance *gb) {
+    gb->cpu.reg.de++;
+    gb->cpu.cycles += 2;
 }
 
-static inline void x18_jr_r8(emu_cpu *cpu) {
-    int8_t r8 = (int8_t)read_d8(cpu);
-    cpu->reg.pc += (int16_t)r8;
-    cpu->cycles += 3;
+static inline void x14_inc_d(gb_instance *gb) {
+    inc_8(gb, &gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x19_add_hl_de(emu_cpu *cpu) {
-    set_HL(add_16(get_HL(), get_DE()));
-    cpu->cycles += 2;
+static inline void x15_dec_d(gb_instance *gb) {
+    dec_8(gb, &gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x1a_ld_a_mde(emu_cpu *cpu) {
-    cpu->reg.a = bus_read(get_DE());
-    cpu->cycles += 2;
+static inline void x16_ld_d_d8(gb_instance *gb) {
+    gb->cpu.reg.d = read_d8(gb);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x1b_dec_de(emu_cpu *cpu) {
-    set_DE(get_DE() - 1);
-    cpu->cycles += 2;
+static inline void x17_rla(gb_instance *gb) {
+    gb->cpu.reg.a = rl_8(gb, gb->cpu.reg.a);
+    set_Z(&gb->cpu, 0);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x1c_inc_e(emu_cpu *cpu) {
-    inc_8(cpu, &cpu->reg.e);
-    cpu->cycles += 1;
+static inline void x18_jr_r8(gb_instance *gb) {
+    int8_t r8 = (int8_t)read_d8(gb);
+    gb->cpu.reg.pc += (int16_t)r8;
+    gb->cpu.cycles += 3;
 }
 
-static inline void x1d_dec_e(emu_cpu *cpu) {
-    dec_8(cpu, &cpu->reg.e);
-    cpu->cycles += 1;
+static inline void x19_add_hl_de(gb_instance *gb) {
+    gb->cpu.reg.hl = add_16(gb, gb->cpu.reg.hl, gb->cpu.reg.de);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x1e_ld_e_d8(emu_cpu *cpu) {
-    cpu->reg.e = read_d8(cpu);
-    cpu->cycles += 2;
+static inline void x1a_ld_a_mde(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = mem_read(gb, gb->cpu.reg.de);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x20_jr_nz_r8(emu_cpu *cpu) {
-    int8_t r8 = (int8_t)read_d8(cpu);
+static inline void x1b_dec_de(gb_instance *gb) {
+    gb->cpu.reg.de--;
+    gb->cpu.cycles += 2;
+}
+
+static inline void x1c_inc_e(gb_instance *gb) {
+    inc_8(gb, &gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
+}
+
+static inline void x1d_dec_e(gb_instance *gb) {
+    dec_8(gb, &gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
+}
+
+static inline void x1e_ld_e_d8(gb_instance *gb) {
+    gb->cpu.reg.e = read_d8(gb);
+    gb->cpu.cycles += 2;
+}
+
+static inline void x1f_rra(gb_instance *gb) {
+    gb->cpu.reg.a = rr_8(gb, gb->cpu.reg.a);
+    set_Z(&gb->cpu, 0);
+    gb->cpu.cycles += 1;
+}
 
-    if (!flag_Z()) {
-        cpu->reg.pc += (int16_t)r8;
-        cpu->cycles += 3;
+static inline void x20_jr_nz_r8(gb_instance *gb) {
+    int8_t r8 = (int8_t)read_d8(gb);
+
+    if (!flag_Z(&gb->cpu)) {
+        gb->cpu.reg.pc += (int16_t)r8;
+        gb->cpu.cycles += 3;
     } else {
-        cpu->cycles += 2;
+        gb->cpu.cycles += 2;
     }
 }
 
-static inline void x21_ld_hl_d16(emu_cpu *cpu) {
-    set_HL(read_d16(cpu));
-    cpu->cycles += 3;
+static inline void x21_ld_hl_d16(gb_instance *gb) {
+    gb->cpu.reg.hl = read_d16(gb);
+    gb->cpu.cycles += 3;
 }
 
-static inline void x22_ldi_mhl_a(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.a);
-    set_HL(get_HL() + 1);
-    cpu->cycles += 2;
+static inline void x22_ldi_mhl_a(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl++, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x23_inc_hl(emu_cpu *cpu) {
-    set_HL(get_HL() + 1);
-    cpu->cycles += 2;
+static inline void x23_inc_hl(gb_instance *gb) {
+    gb->cpu.reg.hl++;
+    gb->cpu.cycles += 2;
 }
 
-static inline void x24_inc_h(emu_cpu *cpu) {
-    inc_8(cpu, &cpu->reg.h);
-    cpu->cycles += 1;
+static inline void x24_inc_h(gb_instance *gb) {
+    inc_8(gb, &gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x25_dec_h(emu_cpu *cpu) {
-    dec_8(cpu, &cpu->reg.h);
-    cpu->cycles += 1;
+static inline void x25_dec_h(gb_instance *gb) {
+    dec_8(gb, &gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x26_ld_h_d8(emu_cpu *cpu) {
-    cpu->reg.h = read_d8(cpu);
-    cpu->cycles += 2;
+static inline void x26_ld_h_d8(gb_instance *gb) {
+    gb->cpu.reg.h = read_d8(gb);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x27_daa(emu_cpu *cpu) {
-    uint8_t a = cpu->reg.a;
+static inline void x27_daa(gb_instance *gb) {
+    uint8_t a = gb->cpu.reg.a;
     uint8_t adjust = 0;
-    uint8_t c = flag_C();
+    uint8_t c = flag_C(&gb->cpu);
 
-    if (!flag_N()) {
-        if (flag_H() || (a & 0x0F) > 9) {
+    if (!flag_N(&gb->cpu)) {
+        if (flag_H(&gb->cpu) || (a & 0x0F) > 9) {
             adjust |= 0x06;
         }
 
-        if (flag_C() || a > 0x99) {
+        if (flag_C(&gb->cpu) || a > 0x99) {
             adjust |= 0x60;
             c = 1;
         }
 
         a += adjust;
     } else {
-        if (flag_H()) {
+        if (flag_H(&gb->cpu)) {
             adjust |= 0x06;
         }
 
-        if (flag_C()) {
+        if (flag_C(&gb->cpu)) {
             adjust |= 0x60;
         }
 
         a -= adjust;
     }
 
-    cpu->reg.a = a;
+    gb->cpu.reg.a = a;
 
-    set_Z(a == 0);
-    set_H(0);
-    set_C(c);
+    flags_znhc(&gb->cpu, a, flag_N(&gb->cpu), 0, (uint16_t)c << 8);
 
-    cpu->cycles += 1;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x28_jr_z_r8(emu_cpu *cpu) {
-    int8_t r8 = (int8_t)read_d8(cpu);
+static inline void x28_jr_z_r8(gb_instance *gb) {
+    int8_t r8 = (int8_t)read_d8(gb);
 
-    if (flag_Z()) {
-        cpu->reg.pc += (int16_t)r8;
-        cpu->cycles += 3;
+    if (flag_Z(&gb->cpu)) {
+        gb->cpu.reg.pc += (int16_t)r8;
+        gb->cpu.cycles += 3;
     } else {
-        cpu->cycles += 2;
+        gb->cpu.cycles += 2;
     }
 }
 
-static inline void x29_add_hl_hl(emu_cpu *cpu) {
-    set_HL(add_16(get_HL(), get_HL()));
-    cpu->cycles += 2;
+static inline void x29_add_hl_hl(gb_instance *gb) {
+    gb->cpu.reg.hl = add_16(gb, gb->cpu.reg.hl, gb->cpu.reg.hl);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x2a_ldi_a_mhl(emu_cpu *cpu) {
-    cpu->reg.a = bus_read(get_HL());
-    set_HL(get_HL() + 1);
-    cpu->cycles +=2;
+static inline void x2a_ldi_a_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = mem_read(gb, gb->cpu.reg.hl++);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x2b_dec_hl(emu_cpu *cpu) {
-    set_HL(get_HL() - 1);
-    cpu->cycles += 2;
+static inline void x2b_dec_hl(gb_instance *gb) {
+    gb->cpu.reg.hl--;
+    gb->cpu.cycles += 2;
 }
 
-static inline void x2c_inc_l(emu_cpu *cpu) {
-    inc_8(cpu, &cpu->reg.l);
-    cpu->cycles += 1;
+static inline void x2c_inc_l(gb_instance *gb) {
+    inc_8(gb, &gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x2d_dec_l(emu_cpu *cpu) {
-    dec_8(cpu, &cpu->reg.l);
-    cpu->cycles += 1;
+static inline void x2d_dec_l(gb_instance *gb) {
+    dec_8(gb, &gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x2e_ld_l_d8(emu_cpu *cpu) {
-    cpu->reg.l = read_d8(cpu);
-    cpu->cycles += 2;
+static inline void x2e_ld_l_d8(gb_instance *gb) {
+    gb->cpu.reg.l = read_d8(gb);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x2f_cpl(emu_cpu *cpu) {
-    cpu->reg.a = cpu->reg.a ^ 0xFF;
-    set_N(1);
-    set_H(1);
-    cpu->cycles += 1;
+static inline void x2f_cpl(gb_instance *gb) {
+    gb->cpu.reg.a = gb->cpu.reg.a ^ 0xFF;
+    set_N(&gb->cpu, 1);
+    set_H(&gb->cpu, 1);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x30_jr_nc_r8(emu_cpu *cpu) {
-    int8_t r8 = (int8_t)read_d8(cpu);
+static inline void x30_jr_nc_r8(gb_instance *gb) {
+    int8_t r8 = (int8_t)read_d8(gb);
 
-    if (!flag_C()) {
-        cpu->reg.pc += (int16_t)r8;
-        cpu->cycles += 3;
+    if (!flag_C(&gb->cpu)) {
+        gb->cpu.reg.pc += (int16_t)r8;
+        gb->cpu.cycles += 3;
     } else {
-        cpu->cycles += 2;
+        gb->cpu.cycles += 2;
     }
 }
 
-static inline void x31_ld_sp_d16(emu_cpu *cpu) {
-    cpu->reg.sp = read_d16(cpu);
-    cpu->cycles += 3;
+static inline void x31_ld_sp_d16(gb_instance *gb) {
+    gb->cpu.reg.sp = read_d16(gb);
+    gb->cpu.cycles += 3;
 }
 
-static inline void x32_ldd_mhl_a(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.a);
-    set_HL(get_HL() - 1);
-    cpu->cycles += 2;
+static inline void x32_ldd_mhl_a(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl--, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x33_inc_sp(emu_cpu *cpu) {
-    cpu->reg.sp++;
-    cpu->cycles += 2;
+static inline void x33_inc_sp(gb_instance *gb) {
+    gb->cpu.reg.sp++;
+    gb->cpu.cycles += 2;
 }
 
-static inline void x34_inc_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    inc_8(cpu, &data);
-    bus_write(get_HL(), data);
-    cpu->cycles += 2;
+static inline void x34_inc_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
+    inc_8(gb, &data);
+    mem_write(gb, gb->cpu.reg.hl, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x35_dec_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    dec_8(cpu, &data);
-    bus_write(get_HL(), data);
-    cpu->cycles += 2;
+static inline void x35_dec_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
+    dec_8(gb, &data);
+    mem_write(gb, gb->cpu.reg.hl, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x36_ld_mhl_d8(emu_cpu *cpu) {
-    uint8_t d8 = read_d8(cpu);
-    cpu->cycles += 1;
-    bus_write(get_HL(), d8);
-    cpu->cycles += 2;
+static inline void x36_ld_mhl_d8(gb_instance *gb) {
+    uint8_t d8 = read_d8(gb);
+    gb->cpu.cycles += 2;
+    mem_write(gb, gb->cpu.reg.hl, d8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x37_scf(emu_cpu *cpu) {
-    set_N(0);
-    set_H(0);
-    set_C(1);
-    cpu->cycles += 1;
+static inline void x37_scf(gb_instance *gb) {
+    flags_nhc(&gb->cpu, 0, 0, 0x100);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x38_jr_c_r8(emu_cpu *cpu) {
-    int8_t r8 = (int8_t)read_d8(cpu);
+static inline void x38_jr_c_r8(gb_instance *gb) {
+    int8_t r8 = (int8_t)read_d8(gb);
 
-    if (flag_C()) {
-        cpu->reg.pc += (int16_t)r8;
-        cpu->cycles += 3;
+    if (flag_C(&gb->cpu)) {
+        gb->cpu.reg.pc += (int16_t)r8;
+        gb->cpu.cycles += 3;
     } else {
-        cpu->cycles += 2;
+        gb->cpu.cycles += 2;
     }
 }
 
-static inline void x39_add_hl_sp(emu_cpu *cpu) {
-    set_HL(add_16(get_HL(), cpu->reg.sp));
-    cpu->cycles += 2;
+static inline void x39_add_hl_sp(gb_instance *gb) {
+    gb->cpu.reg.hl = add_16(gb, gb->cpu.reg.hl, gb->cpu.reg.sp);
+    gb->cpu.cycles += 2;
+}
+
+static inline void x3a_ldd_a_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = mem_read(gb, gb->cpu.reg.hl--);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x3a_ldd_a_mhl(emu_cpu *cpu) {
-    cpu->reg.a = bus_read(get_HL());
-    set_HL(get_HL() - 1);
-    cpu->cycles += 2;
+static inline void x3b_dec_sp(gb_instance *gb) {
+    gb->cpu.reg.sp--;
+    gb->cpu.cycles += 2;
 }
 
-static inline void x3b_dec_sp(emu_cpu *cpu) {
-    cpu->reg.sp--;
-    cpu->cycles += 2;
+static inline void x3c_inc_a(gb_instance *gb) {
+    inc_8(gb, &gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x3c_inc_a(emu_cpu *cpu) {
-    inc_8(cpu, &cpu->reg.a);
-    cpu->cycles += 1;
+static inline void x3d_dec_a(gb_instance *gb) {
+    dec_8(gb, &gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x3d_dec_a(emu_cpu *cpu) {
-    dec_8(cpu, &cpu->reg.a);
-    cpu->cycles += 1;
+static inline void x3e_ld_a_d8(gb_instance *gb) {
+    gb->cpu.reg.a = read_d8(gb);
+    gb->cpu.cycles += 2;
 }
 
-static inline void x3e_ld_a_d8(emu_cpu *cpu) {
-    cpu->reg.a = read_d8(cpu);
-    cpu->cycles += 2;
+static inline void x3f_ccf(gb_instance *gb) {
+    flags_nhc(&gb->cpu, 0, 0, flag_C(&gb->cpu) ? 0 : 0x100);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x3f_ccf(emu_cpu *cpu) {
-    set_N(0);
-    set_H(0);
-    set_C(!flag_C());
-    cpu->cycles += 1;
+static inline void x40_ld_b_b(gb_instance *gb) {
+    gb->cpu.reg.b = gb->cpu.reg.b;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x40_ld_b_b(emu_cpu *cpu) {
-    cpu->reg.b = cpu->reg.b;
-    cpu->cycles += 1;
+static inline void x41_ld_b_c(gb_instance *gb) {
+    gb->cpu.reg.b = gb->cpu.reg.c;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x41_ld_b_c(emu_cpu *cpu) {
-    cpu->reg.b = cpu->reg.c;
-    cpu->cycles += 1;
+static inline void x42_ld_b_d(gb_instance *gb) {
+    gb->cpu.reg.b = gb->cpu.reg.d;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x42_ld_b_d(emu_cpu *cpu) {
-    cpu->reg.b = cpu->reg.d;
-    cpu->cycles += 1;
+static inline void x43_ld_b_e(gb_instance *gb) {
+    gb->cpu.reg.b = gb->cpu.reg.e;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x43_ld_b_e(emu_cpu *cpu) {
-    cpu->reg.b = cpu->reg.e;
-    cpu->cycles += 1;
+static inline void x44_ld_b_h(gb_instance *gb) {
+    gb->cpu.reg.b = gb->cpu.reg.h;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x44_ld_b_h(emu_cpu *cpu) {
-    cpu->reg.b = cpu->reg.h;
-    cpu->cycles += 1;
+static inline void x45_ld_b_l(gb_instance *gb) {
+    gb->cpu.reg.b = gb->cpu.reg.l;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x45_ld_b_l(emu_cpu *cpu) {
-    cpu->reg.b = cpu->reg.l;
-    cpu->cycles += 1;
+static inline void x46_ld_b_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.b = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x46_ld_b_mhl(emu_cpu *cpu) {
-    cpu->reg.b = bus_read(get_HL());
-    cpu->cycles += 2;
+static inline void x47_ld_b_a(gb_instance *gb) {
+    gb->cpu.reg.b = gb->cpu.reg.a;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x47_ld_b_a(emu_cpu *cpu) {
-    cpu->reg.b = cpu->reg.a;
-    cpu->cycles += 1;
+static inline void x48_ld_c_b(gb_instance *gb) {
+    gb->cpu.reg.c = gb->cpu.reg.b;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x48_ld_c_b(emu_cpu *cpu) {
-    cpu->reg.c = cpu->reg.b;
-    cpu->cycles += 1;
+static inline void x49_ld_c_c(gb_instance *gb) {
+    gb->cpu.reg.c = gb->cpu.reg.c;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x49_ld_c_c(emu_cpu *cpu) {
-    cpu->reg.c = cpu->reg.c;
-    cpu->cycles += 1;
+static inline void x4a_ld_c_d(gb_instance *gb) {
+    gb->cpu.reg.c = gb->cpu.reg.d;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x4a_ld_c_d(emu_cpu *cpu) {
-    cpu->reg.c = cpu->reg.d;
-    cpu->cycles += 1;
+static inline void x4b_ld_c_e(gb_instance *gb) {
+    gb->cpu.reg.c = gb->cpu.reg.e;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x4b_ld_c_e(emu_cpu *cpu) {
-    cpu->reg.c = cpu->reg.e;
-    cpu->cycles += 1;
+static inline void x4c_ld_c_h(gb_instance *gb) {
+    gb->cpu.reg.c = gb->cpu.reg.h;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x4c_ld_c_h(emu_cpu *cpu) {
-    cpu->reg.c = cpu->reg.h;
-    cpu->cycles += 1;
+static inline void x4d_ld_c_l(gb_instance *gb) {
+    gb->cpu.reg.c = gb->cpu.reg.l;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x4d_ld_c_l(emu_cpu *cpu) {
-    cpu->reg.c = cpu->reg.l;
-    cpu->cycles += 1;
+static inline void x4e_ld_c_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.c = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x4e_ld_c_mhl(emu_cpu *cpu) {
-    cpu->reg.c = bus_read(get_HL());
-    cpu->cycles += 2;
+static inline void x4f_ld_c_a(gb_instance *gb) {
+    gb->cpu.reg.c = gb->cpu.reg.a;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x4f_ld_c_a(emu_cpu *cpu) {
-    cpu->reg.c = cpu->reg.a;
-    cpu->cycles += 1;
+static inline void x50_ld_d_b(gb_instance *gb) {
+    gb->cpu.reg.d = gb->cpu.reg.b;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x50_ld_d_b(emu_cpu *cpu) {
-    cpu->reg.d = cpu->reg.b;
-    cpu->cycles += 1;
+static inline void x51_ld_d_c(gb_instance *gb) {
+    gb->cpu.reg.d = gb->cpu.reg.c;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x51_ld_d_c(emu_cpu *cpu) {
-    cpu->reg.d = cpu->reg.c;
-    cpu->cycles += 1;
+static inline void x52_ld_d_d(gb_instance *gb) {
+    gb->cpu.reg.d = gb->cpu.reg.d;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x52_ld_d_d(emu_cpu *cpu) {
-    cpu->reg.d = cpu->reg.d;
-    cpu->cycles += 1;
+static inline void x53_ld_d_e(gb_instance *gb) {
+    gb->cpu.reg.d = gb->cpu.reg.e;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x53_ld_d_e(emu_cpu *cpu) {
-    cpu->reg.d = cpu->reg.e;
-    cpu->cycles += 1;
+static inline void x54_ld_d_h(gb_instance *gb) {
+    gb->cpu.reg.d = gb->cpu.reg.h;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x54_ld_d_h(emu_cpu *cpu) {
-    cpu->reg.d = cpu->reg.h;
-    cpu->cycles += 1;
+static inline void x55_ld_d_l(gb_instance *gb) {
+    gb->cpu.reg.d = gb->cpu.reg.l;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x55_ld_d_l(emu_cpu *cpu) {
-    cpu->reg.d = cpu->reg.l;
-    cpu->cycles += 1;
+static inline void x56_ld_d_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.d = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x56_ld_d_mhl(emu_cpu *cpu) {
-    cpu->reg.d = bus_read(get_HL());
-    cpu->cycles += 2;
+static inline void x57_ld_d_a(gb_instance *gb) {
+    gb->cpu.reg.d = gb->cpu.reg.a;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x57_ld_d_a(emu_cpu *cpu) {
-    cpu->reg.d = cpu->reg.a;
-    cpu->cycles += 1;
+static inline void x58_ld_e_b(gb_instance *gb) {
+    gb->cpu.reg.e = gb->cpu.reg.b;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x58_ld_e_b(emu_cpu *cpu) {
-    cpu->reg.e = cpu->reg.b;
-    cpu->cycles += 1;
+static inline void x59_ld_e_c(gb_instance *gb) {
+    gb->cpu.reg.e = gb->cpu.reg.c;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x59_ld_e_c(emu_cpu *cpu) {
-    cpu->reg.e = cpu->reg.c;
-    cpu->cycles += 1;
+static inline void x5a_ld_e_d(gb_instance *gb) {
+    gb->cpu.reg.e = gb->cpu.reg.d;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x5a_ld_e_d(emu_cpu *cpu) {
-    cpu->reg.e = cpu->reg.d;
-    cpu->cycles += 1;
+static inline void x5b_ld_e_e(gb_instance *gb) {
+    gb->cpu.reg.e = gb->cpu.reg.e;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x5b_ld_e_e(emu_cpu *cpu) {
-    cpu->reg.e = cpu->reg.e;
-    cpu->cycles += 1;
+static inline void x5c_ld_e_h(gb_instance *gb) {
+    gb->cpu.reg.e = gb->cpu.reg.h;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x5c_ld_e_h(emu_cpu *cpu) {
-    cpu->reg.e = cpu->reg.h;
-    cpu->cycles += 1;
+static inline void x5d_ld_e_l(gb_instance *gb) {
+    gb->cpu.reg.e = gb->cpu.reg.l;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x5d_ld_e_l(emu_cpu *cpu) {
-    cpu->reg.e = cpu->reg.l;
-    cpu->cycles += 1;
+static inline void x5e_ld_e_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.e = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x5e_ld_e_mhl(emu_cpu *cpu) {
-    cpu->reg.e = bus_read(get_HL());
-    cpu->cycles += 2;
+static inline void x5f_ld_e_a(gb_instance *gb) {
+    gb->cpu.reg.e = gb->cpu.reg.a;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x5f_ld_e_a(emu_cpu *cpu) {
-    cpu->reg.e = cpu->reg.a;
-    cpu->cycles += 1;
+static inline void x60_ld_h_b(gb_instance *gb) {
+    gb->cpu.reg.h = gb->cpu.reg.b;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x60_ld_h_b(emu_cpu *cpu) {
-    cpu->reg.h = cpu->reg.b;
-    cpu->cycles += 1;
+static inline void x61_ld_h_c(gb_instance *gb) {
+    gb->cpu.reg.h = gb->cpu.reg.c;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x61_ld_h_c(emu_cpu *cpu) {
-    cpu->reg.h = cpu->reg.c;
-    cpu->cycles += 1;
+static inline void x62_ld_h_d(gb_instance *gb) {
+    gb->cpu.reg.h = gb->cpu.reg.d;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x62_ld_h_d(emu_cpu *cpu) {
-    cpu->reg.h = cpu->reg.d;
-    cpu->cycles += 1;
+static inline void x63_ld_h_e(gb_instance *gb) {
+    gb->cpu.reg.h = gb->cpu.reg.e;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x63_ld_h_e(emu_cpu *cpu) {
-    cpu->reg.h = cpu->reg.e;
-    cpu->cycles += 1;
+static inline void x64_ld_h_h(gb_instance *gb) {
+    gb->cpu.reg.h = gb->cpu.reg.h;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x64_ld_h_h(emu_cpu *cpu) {
-    cpu->reg.h = cpu->reg.h;
-    cpu->cycles += 1;
+static inline void x65_ld_h_l(gb_instance *gb) {
+    gb->cpu.reg.h = gb->cpu.reg.l;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x65_ld_h_l(emu_cpu *cpu) {
-    cpu->reg.h = cpu->reg.l;
-    cpu->cycles += 1;
+static inline void x66_ld_h_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.h = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x66_ld_h_mhl(emu_cpu *cpu) {
-    cpu->reg.h = bus_read(get_HL());
-    cpu->cycles += 2;
+static inline void x67_ld_h_a(gb_instance *gb) {
+    gb->cpu.reg.h = gb->cpu.reg.a;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x67_ld_h_a(emu_cpu *cpu) {
-    cpu->reg.h = cpu->reg.a;
-    cpu->cycles += 1;
+static inline void x68_ld_l_b(gb_instance *gb) {
+    gb->cpu.reg.l = gb->cpu.reg.b;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x68_ld_l_b(emu_cpu *cpu) {
-    cpu->reg.l = cpu->reg.b;
-    cpu->cycles += 1;
+static inline void x69_ld_l_c(gb_instance *gb) {
+    gb->cpu.reg.l = gb->cpu.reg.c;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x69_ld_l_c(emu_cpu *cpu) {
-    cpu->reg.l = cpu->reg.c;
-    cpu->cycles += 1;
+static inline void x6a_ld_l_d(gb_instance *gb) {
+    gb->cpu.reg.l = gb->cpu.reg.d;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x6a_ld_l_d(emu_cpu *cpu) {
-    cpu->reg.l = cpu->reg.d;
-    cpu->cycles += 1;
+static inline void x6b_ld_l_e(gb_instance *gb) {
+    gb->cpu.reg.l = gb->cpu.reg.e;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x6b_ld_l_e(emu_cpu *cpu) {
-    cpu->reg.l = cpu->reg.e;
-    cpu->cycles += 1;
+static inline void x6c_ld_l_h(gb_instance *gb) {
+    gb->cpu.reg.l = gb->cpu.reg.h;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x6c_ld_l_h(emu_cpu *cpu) {
-    cpu->reg.l = cpu->reg.h;
-    cpu->cycles += 1;
+static inline void x6d_ld_l_l(gb_instance *gb) {
+    gb->cpu.reg.l = gb->cpu.reg.l;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x6d_ld_l_l(emu_cpu *cpu) {
-    cpu->reg.l = cpu->reg.l;
-    cpu->cycles += 1;
+static inline void x6e_ld_l_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.l = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x6e_ld_l_mhl(emu_cpu *cpu) {
-    cpu->reg.l = bus_read(get_HL());
-    cpu->cycles += 2;
+static inline void x6f_ld_l_a(gb_instance *gb) {
+    gb->cpu.reg.l = gb->cpu.reg.a;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x6f_ld_l_a(emu_cpu *cpu) {
-    cpu->reg.l = cpu->reg.a;
-    cpu->cycles += 1;
+static inline void x70_ld_mhl_b(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x70_ld_mhl_b(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.b);
-    cpu->cycles += 2;
+static inline void x71_ld_mhl_c(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x71_ld_mhl_c(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.c);
-    cpu->cycles += 2;
+static inline void x72_ld_mhl_d(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x72_ld_mhl_d(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.d);
-    cpu->cycles += 2;
+static inline void x73_ld_mhl_e(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x73_ld_mhl_e(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.e);
-    cpu->cycles += 2;
+static inline void x74_ld_mhl_h(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x74_ld_mhl_h(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.h);
-    cpu->cycles += 2;
+static inline void x75_ld_mhl_l(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x75_ld_mhl_l(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.l);
-    cpu->cycles += 2;
+// the run loop fast-forwards a halted CPU to the next event instead of spinning
+static inline void x76_halt(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    interrupt_halt(gb);
 }
 
-static inline void x77_ld_mhl_a(emu_cpu *cpu) {
-    bus_write(get_HL(), cpu->reg.a);
-    cpu->cycles += 2;
+static inline void x77_ld_mhl_a(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, gb->cpu.reg.hl, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x78_ld_a_b(emu_cpu *cpu) {
-    cpu->reg.a = cpu->reg.b;
-    cpu->cycles += 1;
+static inline void x78_ld_a_b(gb_instance *gb) {
+    gb->cpu.reg.a = gb->cpu.reg.b;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x79_ld_a_c(emu_cpu *cpu) {
-    cpu->reg.a = cpu->reg.c;
-    cpu->cycles += 1;
+static inline void x79_ld_a_c(gb_instance *gb) {
+    gb->cpu.reg.a = gb->cpu.reg.c;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x7a_ld_a_d(emu_cpu *cpu) {
-    cpu->reg.a = cpu->reg.d;
-    cpu->cycles += 1;
+static inline void x7a_ld_a_d(gb_instance *gb) {
+    gb->cpu.reg.a = gb->cpu.reg.d;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x7b_ld_a_e(emu_cpu *cpu) {
-    cpu->reg.a = cpu->reg.e;
-    cpu->cycles += 1;
+static inline void x7b_ld_a_e(gb_instance *gb) {
+    gb->cpu.reg.a = gb->cpu.reg.e;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x7c_ld_a_h(emu_cpu *cpu) {
-    cpu->reg.a = cpu->reg.h;
-    cpu->cycles += 1;
+static inline void x7c_ld_a_h(gb_instance *gb) {
+    gb->cpu.reg.a = gb->cpu.reg.h;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x7d_ld_a_l(emu_cpu *cpu) {
-    cpu->reg.a = cpu->reg.l;
-    cpu->cycles += 1;
+static inline void x7d_ld_a_l(gb_instance *gb) {
+    gb->cpu.reg.a = gb->cpu.reg.l;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x7e_ld_a_mhl(emu_cpu *cpu) {
-    cpu->reg.a = bus_read(get_HL());
-    cpu->cycles += 2;
+static inline void x7e_ld_a_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x7f_ld_a_a(emu_cpu *cpu) {
-    cpu->reg.a = cpu->reg.a;
-    cpu->cycles += 1;
+static inline void x7f_ld_a_a(gb_instance *gb) {
+    gb->cpu.reg.a = gb->cpu.reg.a;
+    gb->cpu.cycles += 1;
 }
 
-static inline void x80_add_a_b(emu_cpu *cpu) {
-    cpu->reg.a = add_8(cpu->reg.a, cpu->reg.b);
-    cpu->cycles += 1;
+static inline void x80_add_a_b(gb_instance *gb) {
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x81_add_a_c(emu_cpu *cpu) {
-    cpu->reg.a = add_8(cpu->reg.a, cpu->reg.c);
-    cpu->cycles += 1;
+static inline void x81_add_a_c(gb_instance *gb) {
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x82_add_a_d(emu_cpu *cpu) {
-    cpu->reg.a = add_8(cpu->reg.a, cpu->reg.d);
-    cpu->cycles += 1;
+static inline void x82_add_a_d(gb_instance *gb) {
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x83_add_a_e(emu_cpu *cpu) {
-    cpu->reg.a = add_8(cpu->reg.a, cpu->reg.e);
-    cpu->cycles += 1;
+static inline void x83_add_a_e(gb_instance *gb) {
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x84_add_a_h(emu_cpu *cpu) {
-    cpu->reg.a = add_8(cpu->reg.a, cpu->reg.h);
-    cpu->cycles += 1;
+static inline void x84_add_a_h(gb_instance *gb) {
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x85_add_a_l(emu_cpu *cpu) {
-    cpu->reg.a = add_8(cpu->reg.a, cpu->reg.l);
-    cpu->cycles += 1;
+static inline void x85_add_a_l(gb_instance *gb) {
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x86_add_a_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    cpu->reg.a = add_8(cpu->reg.a, data);
-    cpu->cycles += 1;
+static inline void x86_add_a_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x87_add_a_a(emu_cpu *cpu) {
-    cpu->reg.a = add_8(cpu->reg.a, cpu->reg.a);
-    cpu->cycles += 1;
+static inline void x87_add_a_a(gb_instance *gb) {
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x88_adc_a_b(emu_cpu *cpu) {
-    cpu->reg.a = adc_8(cpu->reg.a, cpu->reg.b);
-    cpu->cycles += 1;
+static inline void x88_adc_a_b(gb_instance *gb) {
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x89_adc_a_c(emu_cpu *cpu) {
-    cpu->reg.a = adc_8(cpu->reg.a, cpu->reg.c);
-    cpu->cycles += 1;
+static inline void x89_adc_a_c(gb_instance *gb) {
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x8a_adc_a_d(emu_cpu *cpu) {
-    cpu->reg.a = adc_8(cpu->reg.a, cpu->reg.d);
-    cpu->cycles += 1;
+static inline void x8a_adc_a_d(gb_instance *gb) {
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x8b_adc_a_e(emu_cpu *cpu) {
-    cpu->reg.a = adc_8(cpu->reg.a, cpu->reg.e);
-    cpu->cycles += 1;
+static inline void x8b_adc_a_e(gb_instance *gb) {
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x8c_adc_a_h(emu_cpu *cpu) {
-    cpu->reg.a = adc_8(cpu->reg.a, cpu->reg.h);
-    cpu->cycles += 1;
+static inline void x8c_adc_a_h(gb_instance *gb) {
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x8d_adc_a_l(emu_cpu *cpu) {
-    cpu->reg.a = adc_8(cpu->reg.a, cpu->reg.l);
-    cpu->cycles += 1;
+static inline void x8d_adc_a_l(gb_instance *gb) {
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x8e_adc_a_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    cpu->reg.a = adc_8(cpu->reg.a, data);
-    cpu->cycles += 1;
+static inline void x8e_adc_a_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x8f_adc_a_a(emu_cpu *cpu) {
-    cpu->reg.a = adc_8(cpu->reg.a, cpu->reg.a);
-    cpu->cycles += 1;
+static inline void x8f_adc_a_a(gb_instance *gb) {
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x90_sub_b(emu_cpu *cpu) {
-    cpu->reg.a = sub_8(cpu->reg.a, cpu->reg.b);
-    cpu->cycles += 1;
+static inline void x90_sub_b(gb_instance *gb) {
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x91_sub_c(emu_cpu *cpu) {
-    cpu->reg.a = sub_8(cpu->reg.a, cpu->reg.c);
-    cpu->cycles += 1;
+static inline void x91_sub_c(gb_instance *gb) {
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x92_sub_d(emu_cpu *cpu) {
-    cpu->reg.a = sub_8(cpu->reg.a, cpu->reg.d);
-    cpu->cycles += 1;
+static inline void x92_sub_d(gb_instance *gb) {
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x93_sub_e(emu_cpu *cpu) {
-    cpu->reg.a = sub_8(cpu->reg.a, cpu->reg.e);
-    cpu->cycles += 1;
+static inline void x93_sub_e(gb_instance *gb) {
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x94_sub_h(emu_cpu *cpu) {
-    cpu->reg.a = sub_8(cpu->reg.a, cpu->reg.h);
-    cpu->cycles += 1;
+static inline void x94_sub_h(gb_instance *gb) {
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x95_sub_l(emu_cpu *cpu) {
-    cpu->reg.a = sub_8(cpu->reg.a, cpu->reg.l);
-    cpu->cycles += 1;
+static inline void x95_sub_l(gb_instance *gb) {
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x96_sub_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    cpu->reg.a = sub_8(cpu->reg.a, data);
-    cpu->cycles += 1;
+static inline void x96_sub_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x97_sub_a(emu_cpu *cpu) {
-    cpu->reg.a = sub_8(cpu->reg.a, cpu->reg.a);
-    cpu->cycles += 1;
+static inline void x97_sub_a(gb_instance *gb) {
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x98_sbc_a_b(emu_cpu *cpu) {
-    cpu->reg.a = sbc_8(cpu->reg.a, cpu->reg.b);
-    cpu->cycles += 1;
+static inline void x98_sbc_a_b(gb_instance *gb) {
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x99_sbc_a_c(emu_cpu *cpu) {
-    cpu->reg.a = sbc_8(cpu->reg.a, cpu->reg.c);
-    cpu->cycles += 1;
+static inline void x99_sbc_a_c(gb_instance *gb) {
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x9a_sbc_a_d(emu_cpu *cpu) {
-    cpu->reg.a = sbc_8(cpu->reg.a, cpu->reg.d);
-    cpu->cycles += 1;
+static inline void x9a_sbc_a_d(gb_instance *gb) {
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x9b_sbc_a_e(emu_cpu *cpu) {
-    cpu->reg.a = sbc_8(cpu->reg.a, cpu->reg.e);
-    cpu->cycles += 1;
+static inline void x9b_sbc_a_e(gb_instance *gb) {
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x9c_sbc_a_h(emu_cpu *cpu) {
-    cpu->reg.a = sbc_8(cpu->reg.a, cpu->reg.h);
-    cpu->cycles += 1;
+static inline void x9c_sbc_a_h(gb_instance *gb) {
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x9d_sbc_a_l(emu_cpu *cpu) {
-    cpu->reg.a = sbc_8(cpu->reg.a, cpu->reg.l);
-    cpu->cycles += 1;
+static inline void x9d_sbc_a_l(gb_instance *gb) {
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x9e_sbc_a_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    cpu->reg.a = sbc_8(cpu->reg.a, data);
-    cpu->cycles += 1;
+static inline void x9e_sbc_a_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void x9f_sbc_a_a(emu_cpu *cpu) {
-    cpu->reg.a = sbc_8(cpu->reg.a, cpu->reg.a);
-    cpu->cycles += 1;
+static inline void x9f_sbc_a_a(gb_instance *gb) {
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa0_and_b(emu_cpu *cpu) {
-    cpu->reg.a = and_8(cpu->reg.a, cpu->reg.b);
-    cpu->cycles += 1;
+static inline void xa0_and_b(gb_instance *gb) {
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa1_and_c(emu_cpu *cpu) {
-    cpu->reg.a = and_8(cpu->reg.a, cpu->reg.c);
-    cpu->cycles += 1;
+static inline void xa1_and_c(gb_instance *gb) {
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa2_and_d(emu_cpu *cpu) {
-    cpu->reg.a = and_8(cpu->reg.a, cpu->reg.d);
-    cpu->cycles += 1;
+static inline void xa2_and_d(gb_instance *gb) {
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa3_and_e(emu_cpu *cpu) {
-    cpu->reg.a = and_8(cpu->reg.a, cpu->reg.e);
-    cpu->cycles += 1;
+static inline void xa3_and_e(gb_instance *gb) {
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa4_and_h(emu_cpu *cpu) {
-    cpu->reg.a = and_8(cpu->reg.a, cpu->reg.h);
-    cpu->cycles += 1;
+static inline void xa4_and_h(gb_instance *gb) {
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa5_and_l(emu_cpu *cpu) {
-    cpu->reg.a = and_8(cpu->reg.a, cpu->reg.l);
-    cpu->cycles += 1;
+static inline void xa5_and_l(gb_instance *gb) {
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa6_and_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    cpu->reg.a = and_8(cpu->reg.a, data);
-    cpu->cycles += 1;
+static inline void xa6_and_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa7_and_a(emu_cpu *cpu) {
-    cpu->reg.a = and_8(cpu->reg.a, cpu->reg.a);
-    cpu->cycles += 1;
+static inline void xa7_and_a(gb_instance *gb) {
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa8_xor_b(emu_cpu *cpu) {
-    cpu->reg.a = xor_8(cpu->reg.a, cpu->reg.b);
-    cpu->cycles += 1;
+static inline void xa8_xor_b(gb_instance *gb) {
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xa9_xor_c(emu_cpu *cpu) {
-    cpu->reg.a = xor_8(cpu->reg.a, cpu->reg.c);
-    cpu->cycles += 1;
+static inline void xa9_xor_c(gb_instance *gb) {
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xaa_xor_d(emu_cpu *cpu) {
-    cpu->reg.a = xor_8(cpu->reg.a, cpu->reg.d);
-    cpu->cycles += 1;
+static inline void xaa_xor_d(gb_instance *gb) {
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xab_xor_e(emu_cpu *cpu) {
-    cpu->reg.a = xor_8(cpu->reg.a, cpu->reg.e);
-    cpu->cycles += 1;
+static inline void xab_xor_e(gb_instance *gb) {
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xac_xor_h(emu_cpu *cpu) {
-    cpu->reg.a = xor_8(cpu->reg.a, cpu->reg.h);
-    cpu->cycles += 1;
+static inline void xac_xor_h(gb_instance *gb) {
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xad_xor_l(emu_cpu *cpu) {
-    cpu->reg.a = xor_8(cpu->reg.a, cpu->reg.l);
-    cpu->cycles += 1;
+static inline void xad_xor_l(gb_instance *gb) {
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xae_xor_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    cpu->reg.a = xor_8(cpu->reg.a, data);
-    cpu->cycles += 1;
+static inline void xae_xor_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xaf_xor_a(emu_cpu *cpu) {
-    cpu->reg.a = xor_8(cpu->reg.a, cpu->reg.a);
-    cpu->cycles += 1;
+static inline void xaf_xor_a(gb_instance *gb) {
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb0_or_b(emu_cpu *cpu) {
-    cpu->reg.a = or_8(cpu->reg.a, cpu->reg.b);
-    cpu->cycles += 1;
+static inline void xb0_or_b(gb_instance *gb) {
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb1_or_c(emu_cpu *cpu) {
-    cpu->reg.a = or_8(cpu->reg.a, cpu->reg.c);
-    cpu->cycles += 1;
+static inline void xb1_or_c(gb_instance *gb) {
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb2_or_d(emu_cpu *cpu) {
-    cpu->reg.a = or_8(cpu->reg.a, cpu->reg.d);
-    cpu->cycles += 1;
+static inline void xb2_or_d(gb_instance *gb) {
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb3_or_e(emu_cpu *cpu) {
-    cpu->reg.a = or_8(cpu->reg.a, cpu->reg.e);
-    cpu->cycles += 1;
+static inline void xb3_or_e(gb_instance *gb) {
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb4_or_h(emu_cpu *cpu) {
-    cpu->reg.a = or_8(cpu->reg.a, cpu->reg.h);
-    cpu->cycles += 1;
+static inline void xb4_or_h(gb_instance *gb) {
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb5_or_l(emu_cpu *cpu) {
-    cpu->reg.a = or_8(cpu->reg.a, cpu->reg.l);
-    cpu->cycles += 1;
+static inline void xb5_or_l(gb_instance *gb) {
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb6_or_mhl(emu_cpu *cpu) {
-    uint8_t data = bus_read(get_HL());
-    cpu->cycles += 1;
-    cpu->reg.a = or_8(cpu->reg.a, data);
-    cpu->cycles += 1;
+static inline void xb6_or_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    uint8_t data = mem_read(gb, gb->cpu.reg.hl);
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, data);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb7_or_a(emu_cpu *cpu) {
-    cpu->reg.a = or_8(cpu->reg.a, cpu->reg.a);
-    cpu->cycles += 1;
+static inline void xb7_or_a(gb_instance *gb) {
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb8_cp_b(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, cpu->reg.b);
-    cpu->cycles += 1;
+static inline void xb8_cp_b(gb_instance *gb) {
+    cp_8(gb, gb->cpu.reg.a, gb->cpu.reg.b);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xb9_cp_c(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, cpu->reg.c);
-    cpu->cycles += 1;
+static inline void xb9_cp_c(gb_instance *gb) {
+    cp_8(gb, gb->cpu.reg.a, gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xba_cp_d(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, cpu->reg.d);
-    cpu->cycles += 1;
+static inline void xba_cp_d(gb_instance *gb) {
+    cp_8(gb, gb->cpu.reg.a, gb->cpu.reg.d);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xbb_cp_e(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, cpu->reg.e);
-    cpu->cycles += 1;
+static inline void xbb_cp_e(gb_instance *gb) {
+    cp_8(gb, gb->cpu.reg.a, gb->cpu.reg.e);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xbc_cp_h(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, cpu->reg.h);
-    cpu->cycles += 1;
+static inline void xbc_cp_h(gb_instance *gb) {
+    cp_8(gb, gb->cpu.reg.a, gb->cpu.reg.h);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xbd_cp_l(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, cpu->reg.l);
-    cpu->cycles += 1;
+static inline void xbd_cp_l(gb_instance *gb) {
+    cp_8(gb, gb->cpu.reg.a, gb->cpu.reg.l);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xbe_cp_mhl(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, bus_read(get_HL()));
-    cpu->cycles += 2;
+static inline void xbe_cp_mhl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    cp_8(gb, gb->cpu.reg.a, mem_read(gb, gb->cpu.reg.hl));
+    gb->cpu.cycles += 1;
 }
 
-static inline void xbf_cp_a(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, cpu->reg.a);
-    cpu->cycles += 1;
+static inline void xbf_cp_a(gb_instance *gb) {
+    cp_8(gb, gb->cpu.reg.a, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xc0_ret_nz(emu_cpu *cpu) {
-    if (!flag_Z()) {
-        cpu->reg.pc = pop_16(cpu);
-        cpu->cycles += 5;
+static inline void xc0_ret_nz(gb_instance *gb) {
+    if (!flag_Z(&gb->cpu)) {
+        gb->cpu.cycles += 2;
+        gb->cpu.reg.pc = pop_16(gb);
+        gb->cpu.cycles += 1;
+        CALLSTACK_LEAVE(gb, gb->cpu.reg.sp - 2);
     } else {
-        cpu->cycles += 2;
+        gb->cpu.cycles += 2;
     }
 }
 
-static inline void xc1_pop_bc(emu_cpu *cpu) {
-    set_BC(pop_16(cpu));
-    cpu->cycles += 3;
+static inline void xc1_pop_bc(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.bc = pop_16(gb);
 }
 
-static inline void xc2_jp_nz_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
+static inline void xc2_jp_nz_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
 
-    if (!flag_Z()) {
-        cpu->reg.pc = a16;
-        cpu->cycles += 4;
+    if (!flag_Z(&gb->cpu)) {
+        gb->cpu.reg.pc = a16;
+        gb->cpu.cycles += 4;
     } else {
-        cpu->cycles += 3;
+        gb->cpu.cycles += 3;
     }
 }
 
-static inline void xc3_jp_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->reg.pc = a16;
-    cpu->cycles += 4;
+static inline void xc3_jp_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.reg.pc = a16;
+    gb->cpu.cycles += 4;
 }
 
-static inline void xc4_call_nz_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->cycles += 2;
+static inline void xc4_call_nz_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.cycles += 3;
 
-    if (!flag_Z()) {
-        push_16(cpu, cpu->reg.pc);
-        cpu->reg.pc = a16;
-        cpu->cycles += 4;
-    } else {
-        cpu->cycles += 1;
+    if (!flag_Z(&gb->cpu)) {
+        gb->cpu.cycles += 1;
+        push_16(gb, gb->cpu.reg.pc);
+        gb->cpu.reg.pc = a16;
+        CALLSTACK_ENTER(gb, a16, CALLSTACK_CALL);
     }
 }
 
-static inline void xc5_push_bc(emu_cpu *cpu) {
-    push_16(cpu, get_BC());
-    cpu->cycles += 4;
+static inline void xc5_push_bc(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.bc);
 }
 
-static inline void xc6_add_a_d8(emu_cpu *cpu) {
-    uint8_t d8 = read_d8(cpu);
-    cpu->cycles += 1;
-    cpu->reg.a = add_8(cpu->reg.a, d8);
-    cpu->cycles += 1;
+static inline void xc6_add_a_d8(gb_instance *gb) {
+    uint8_t d8 = read_d8(gb);
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = add_8(gb, gb->cpu.reg.a, d8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xc7_rst_00h(emu_cpu *cpu) {
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = 0x0000;
-    cpu->cycles += 4;
+static inline void xc7_rst_00h(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = 0x0000;
+    CALLSTACK_ENTER(gb, 0x0000, CALLSTACK_CALL);
 }
 
-static inline void xc8_ret_z(emu_cpu *cpu) {
-    if (flag_Z()) {
-        cpu->reg.pc = pop_16(cpu);
-        cpu->cycles += 5;
+static inline void xc8_ret_z(gb_instance *gb) {
+    if (flag_Z(&gb->cpu)) {
+        gb->cpu.cycles += 2;
+        gb->cpu.reg.pc = pop_16(gb);
+        gb->cpu.cycles += 1;
+        CALLSTACK_LEAVE(gb, gb->cpu.reg.sp - 2);
     } else {
-        cpu->cycles += 2;
+        gb->cpu.cycles += 2;
     }
 }
 
-static inline void xc9_ret(emu_cpu *cpu) {
-    cpu->reg.pc = pop_16(cpu);
-    cpu->cycles += 4;
+static inline void xc9_ret(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.pc = pop_16(gb);
+    gb->cpu.cycles += 1;
+    CALLSTACK_LEAVE(gb, gb->cpu.reg.sp - 2);
 }
 
-static inline void xca_jp_z_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
+static inline void xca_jp_z_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
 
-    if (flag_Z()) {
-        cpu->reg.pc = a16;
-        cpu->cycles += 4;
+    if (flag_Z(&gb->cpu)) {
+        gb->cpu.reg.pc = a16;
+        gb->cpu.cycles += 4;
     } else {
-        cpu->cycles += 3;
+        gb->cpu.cycles += 3;
     }
 }
 
-static inline void xcc_call_z_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->cycles += 2;
+static inline void xcc_call_z_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.cycles += 3;
 
-    if (flag_Z()) {
-        push_16(cpu, cpu->reg.pc);
-        cpu->reg.pc = a16;
-        cpu->cycles += 4;
-    } else {
-        cpu->cycles += 1;
+    if (flag_Z(&gb->cpu)) {
+        gb->cpu.cycles += 1;
+        push_16(gb, gb->cpu.reg.pc);
+        gb->cpu.reg.pc = a16;
+        CALLSTACK_ENTER(gb, a16, CALLSTACK_CALL);
     }
 }
 
-static inline void xcd_call_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->cycles += 2;
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = a16;
-    cpu->cycles += 4;
+static inline void xcd_call_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.cycles += 4;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = a16;
+    CALLSTACK_ENTER(gb, a16, CALLSTACK_CALL);
 }
 
-static inline void xce_adc_a_d8(emu_cpu *cpu) {
-    uint8_t d8 = read_d8(cpu);
-    cpu->cycles += 1;
-    cpu->reg.a = adc_8(cpu->reg.a, d8);
-    cpu->cycles += 1;
+static inline void xce_adc_a_d8(gb_instance *gb) {
+    uint8_t d8 = read_d8(gb);
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = adc_8(gb, gb->cpu.reg.a, d8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xcf_rst_08h(emu_cpu *cpu) {
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = 0x0008;
-    cpu->cycles += 4;
+static inline void xcf_rst_08h(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = 0x0008;
+    CALLSTACK_ENTER(gb, 0x0008, CALLSTACK_CALL);
 }
 
-static inline void xd0_ret_nc(emu_cpu *cpu) {
-    if (!flag_C()) {
-        cpu->reg.pc = pop_16(cpu);
-        cpu->cycles += 5;
+static inline void xd0_ret_nc(gb_instance *gb) {
+    if (!flag_C(&gb->cpu)) {
+        gb->cpu.cycles += 2;
+        gb->cpu.reg.pc = pop_16(gb);
+        gb->cpu.cycles += 1;
+        CALLSTACK_LEAVE(gb, gb->cpu.reg.sp - 2);
     } else {
-        cpu->cycles += 2;
+        gb->cpu.cycles += 2;
     }
 }
 
-static inline void xd1_pop_de(emu_cpu *cpu) {
-    set_DE(pop_16(cpu));
-    cpu->cycles += 3;
+static inline void xd1_pop_de(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.de = pop_16(gb);
 }
 
-static inline void xd2_jp_nc_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
+static inline void xd2_jp_nc_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
 
-    if (!flag_C()) {
-        cpu->reg.pc = a16;
-        cpu->cycles += 4;
+    if (!flag_C(&gb->cpu)) {
+        gb->cpu.reg.pc = a16;
+        gb->cpu.cycles += 4;
     } else {
-        cpu->cycles += 3;
+        gb->cpu.cycles += 3;
     }
 }
 
-static inline void xd4_call_nc_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->cycles += 2;
+static inline void xd4_call_nc_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.cycles += 3;
 
-    if (!flag_C()) {
-        push_16(cpu, cpu->reg.pc);
-        cpu->reg.pc = a16;
-        cpu->cycles += 4;
-    } else {
-        cpu->cycles += 1;
+    if (!flag_C(&gb->cpu)) {
+        gb->cpu.cycles += 1;
+        push_16(gb, gb->cpu.reg.pc);
+        gb->cpu.reg.pc = a16;
+        CALLSTACK_ENTER(gb, a16, CALLSTACK_CALL);
     }
 }
 
-static inline void xd5_push_de(emu_cpu *cpu) {
-    push_16(cpu, get_DE());
-    cpu->cycles += 4;
+static inline void xd5_push_de(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.de);
 }
 
-static inline void xd6_sub_d8(emu_cpu *cpu) {
-    uint8_t d8 = read_d8(cpu);
-    cpu->cycles += 1;
-    cpu->reg.a = sub_8(cpu->reg.a, d8);
-    cpu->cycles += 1;
+static inline void xd6_sub_d8(gb_instance *gb) {
+    uint8_t d8 = read_d8(gb);
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = sub_8(gb, gb->cpu.reg.a, d8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xd7_rst_10h(emu_cpu *cpu) {
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = 0x0010;
-    cpu->cycles += 4;
+static inline void xd7_rst_10h(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = 0x0010;
+    CALLSTACK_ENTER(gb, 0x0010, CALLSTACK_CALL);
 }
 
-static inline void xd8_ret_c(emu_cpu *cpu) {
-    if (flag_C()) {
-        cpu->reg.pc = pop_16(cpu);
-        cpu->cycles += 5;
+static inline void xd8_ret_c(gb_instance *gb) {
+    if (flag_C(&gb->cpu)) {
+        gb->cpu.cycles += 2;
+        gb->cpu.reg.pc = pop_16(gb);
+        gb->cpu.cycles += 1;
+        CALLSTACK_LEAVE(gb, gb->cpu.reg.sp - 2);
     } else {
-        cpu->cycles += 2;
+        gb->cpu.cycles += 2;
     }
 }
 
-static inline void xd9_reti(emu_cpu *cpu) {
-    enable_interrupt();
-    xc9_ret(cpu);
+static inline void xd9_reti(gb_instance *gb) {
+    enable_interrupt(gb);
+    xc9_ret(gb);
 }
 
-static inline void xda_jp_c_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
+static inline void xda_jp_c_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
 
-    if (flag_C()) {
-        cpu->reg.pc = a16;
-        cpu->cycles += 4;
+    if (flag_C(&gb->cpu)) {
+        gb->cpu.reg.pc = a16;
+        gb->cpu.cycles += 4;
     } else {
-        cpu->cycles += 3;
+        gb->cpu.cycles += 3;
     }
 }
 
-static inline void xdc_call_c_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->cycles += 2;
+static inline void xdc_call_c_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.cycles += 3;
 
-    if (flag_C()) {
-        push_16(cpu, cpu->reg.pc);
-        cpu->reg.pc = a16;
-        cpu->cycles += 4;
-    } else {
-        cpu->cycles += 1;
+    if (flag_C(&gb->cpu)) {
+        gb->cpu.cycles += 1;
+        push_16(gb, gb->cpu.reg.pc);
+        gb->cpu.reg.pc = a16;
+        CALLSTACK_ENTER(gb, a16, CALLSTACK_CALL);
     }
 }
 
-static inline void xde_sbc_a_d8(emu_cpu *cpu) {
-    uint8_t d8 = read_d8(cpu);
-    cpu->cycles += 1;
-    cpu->reg.a = sbc_8(cpu->reg.a, d8);
-    cpu->cycles += 1;
+static inline void xde_sbc_a_d8(gb_instance *gb) {
+    uint8_t d8 = read_d8(gb);
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = sbc_8(gb, gb->cpu.reg.a, d8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xdf_rst_18h(emu_cpu *cpu) {
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = 0x0018;
-    cpu->cycles += 4;
+static inline void xdf_rst_18h(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = 0x0018;
+    CALLSTACK_ENTER(gb, 0x0018, CALLSTACK_CALL);
 }
 
-static inline void xe0_ldh_m8_a(emu_cpu *cpu) {
-    uint8_t a8 = read_d8(cpu);
-    cpu->cycles += 1;
-    bus_write(0xFF00 + (uint16_t)a8, cpu->reg.a);
-    cpu->cycles += 2;
+static inline void xe0_ldh_m8_a(gb_instance *gb) {
+    uint8_t a8 = read_d8(gb);
+    gb->cpu.cycles += 2;
+    mem_write(gb, 0xFF00 + (uint16_t)a8, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xe1_pop_hl(emu_cpu *cpu) {
-    set_HL(pop_16(cpu));
-    cpu->cycles += 3;
+static inline void xe1_pop_hl(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.hl = pop_16(gb);
 }
 
-static inline void xe5_push_hl(emu_cpu *cpu) {
-    push_16(cpu, get_HL());
-    cpu->cycles += 4;
+static inline void xe5_push_hl(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.hl);
 }
 
-static inline void xe6_and_d8(emu_cpu *cpu) {
-    uint8_t d8 = read_d8(cpu);
-    cpu->cycles += 1;
-    cpu->reg.a = and_8(cpu->reg.a, d8);
-    cpu->cycles += 1;
+static inline void xe6_and_d8(gb_instance *gb) {
+    uint8_t d8 = read_d8(gb);
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = and_8(gb, gb->cpu.reg.a, d8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xe7_rst_20h(emu_cpu *cpu) {
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = 0x0020;
-    cpu->cycles += 4;
+static inline void xe7_rst_20h(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = 0x0020;
+    CALLSTACK_ENTER(gb, 0x0020, CALLSTACK_CALL);
 }
 
-static inline void xe8_add_sp_r8(emu_cpu *cpu) {
-    int8_t   r8 = (int8_t)read_d8(cpu);
-    uint16_t sp = cpu->reg.sp;
+static inline void xe8_add_sp_r8(gb_instance *gb) {
+    int8_t   r8 = (int8_t)read_d8(gb);
+    uint16_t sp = gb->cpu.reg.sp;
     uint16_t u8 = (uint16_t)(uint8_t)r8;
-    cpu->cycles += 1;
-    set_Z(0);
-    set_N(0);
-    set_H(((sp & 0x0F) + (u8 & 0x0F)) > 0x0F);
-    set_C(((sp & 0xFF) + (u8 & 0xFF)) > 0xFF);
-    cpu->reg.sp = sp + r8;
-    cpu->cycles += 3;
+    gb->cpu.cycles += 1;
+    flags_znhc(&gb->cpu, 1, 0, sp ^ u8 ^ (uint16_t)(sp + u8), (sp & 0xFF) + u8);
+    gb->cpu.reg.sp = sp + r8;
+    gb->cpu.cycles += 3;
+}
+
+static inline void xe9_jp_hl(gb_instance *gb) {
+    gb->cpu.reg.pc = gb->cpu.reg.hl;
+    gb->cpu.cycles += 1;
 }
 
-static inline void xe9_jp_hl(emu_cpu *cpu) {
-    cpu->reg.pc = get_HL();
-    cpu->cycles += 1;
+static inline void xea_ld_a16_a(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.cycles += 3;
+    mem_write(gb, a16, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xea_ld_a16_a(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->cycles += 2;
-    bus_write(a16, cpu->reg.a);
-    cpu->cycles += 2;
+static inline void xe2_ld_mc_a(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    mem_write(gb, 0xFF00 + (uint16_t)gb->cpu.reg.c, gb->cpu.reg.a);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xe2_ld_mc_a(emu_cpu *cpu) {
-    bus_write(0xFF00 + (uint16_t)cpu->reg.c, cpu->reg.a);
-    cpu->cycles += 2;
+static inline void xee_xor_d8(gb_instance *gb) {
+    uint8_t d8 = read_d8(gb);
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = xor_8(gb, gb->cpu.reg.a, d8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xee_xor_d8(emu_cpu *cpu) {
-    uint8_t d8 = read_d8(cpu);
-    cpu->cycles += 1;
-    cpu->reg.a = xor_8(cpu->reg.a, d8);
-    cpu->cycles += 1;
+static inline void xef_rst_28h(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = 0x0028;
+    CALLSTACK_ENTER(gb, 0x0028, CALLSTACK_CALL);
 }
 
-static inline void xef_rst_28h(emu_cpu *cpu) {
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = 0x0028;
-    cpu->cycles += 4;
+static inline void xf0_ldh_a_m8(gb_instance *gb) {
+    uint8_t a8 = read_d8(gb);
+    gb->cpu.cycles += 2;
+    gb->cpu.reg.a = mem_read(gb, 0xFF00 + (uint16_t)a8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xf0_ldh_a_m8(emu_cpu *cpu) {
-    uint8_t a8 = read_d8(cpu);
-    cpu->cycles += 1;
-    cpu->reg.a = bus_read(0xFF00 + (uint16_t)a8);
-    cpu->cycles += 2;
+static inline void xf1_pop_af(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    set_AF(&gb->cpu, pop_16(gb));
 }
 
-static inline void xf1_pop_af(emu_cpu *cpu) {
-    set_AF(pop_16(cpu));
-    cpu->cycles += 3;
+static inline void xf2_ld_a_mc(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = mem_read(gb, 0xFF00 + (uint16_t)gb->cpu.reg.c);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xf2_ld_a_mc(emu_cpu *cpu) {
-    cpu->reg.a = bus_read(0xFF00 + (uint16_t)cpu->reg.c);
-    cpu->cycles += 2;
+static inline void xf3_di(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    interrupt_di(gb);
 }
 
-static inline void xf5_push_af(emu_cpu *cpu) {
-    push_16(cpu, get_AF());
-    cpu->cycles += 4;
+static inline void xf5_push_af(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, get_AF(&gb->cpu));
 }
 
-static inline void xf6_or_d8(emu_cpu *cpu) {
-    uint8_t d8 = read_d8(cpu);
-    cpu->cycles += 1;
-    cpu->reg.a = or_8(cpu->reg.a, d8);
-    cpu->cycles += 1;
+static inline void xf6_or_d8(gb_instance *gb) {
+    uint8_t d8 = read_d8(gb);
+    gb->cpu.cycles += 1;
+    gb->cpu.reg.a = or_8(gb, gb->cpu.reg.a, d8);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xf7_rst_30h(emu_cpu *cpu) {
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = 0x0030;
-    cpu->cycles += 4;
+static inline void xf7_rst_30h(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = 0x0030;
+    CALLSTACK_ENTER(gb, 0x0030, CALLSTACK_CALL);
 }
 
-static inline void xf8_ld_hl_sp_r8(emu_cpu *cpu) {
-    uint16_t sp = cpu->reg.sp;
-    int8_t   r8 = (int8_t)read_d8(cpu);
+static inline void xf8_ld_hl_sp_r8(gb_instance *gb) {
+    uint16_t sp = gb->cpu.reg.sp;
+    int8_t   r8 = (int8_t)read_d8(gb);
     uint16_t u8 = (uint16_t)(uint8_t)r8;
-    cpu->cycles += 1;
-    set_Z(0);
-    set_N(0);
-    set_H(((sp & 0x0F) + (u8 & 0x0F)) > 0x0F);
-    set_C(((sp & 0xFF) + u8) > 0xFF);
-    set_HL(sp + r8);
-    cpu->cycles += 2;
+    gb->cpu.cycles += 1;
+    flags_znhc(&gb->cpu, 1, 0, sp ^ u8 ^ (uint16_t)(sp + u8), (sp & 0xFF) + u8);
+    gb->cpu.reg.hl = sp + r8;
+    gb->cpu.cycles += 2;
 }
 
-static inline void xf9_ld_sp_hl(emu_cpu *cpu) {
-    cpu->reg.sp = get_HL();
-    cpu->cycles += 2;
+static inline void xf9_ld_sp_hl(gb_instance *gb) {
+    gb->cpu.reg.sp = gb->cpu.reg.hl;
+    gb->cpu.cycles += 2;
 }
 
-static inline void xfa_ld_a_a16(emu_cpu *cpu) {
-    uint16_t a16 = read_d16(cpu);
-    cpu->cycles += 2;
-    cpu->reg.a = bus_read(a16);
-    cpu->cycles += 2;
+static inline void xfa_ld_a_a16(gb_instance *gb) {
+    uint16_t a16 = read_d16(gb);
+    gb->cpu.cycles += 3;
+    gb->cpu.reg.a = mem_read(gb, a16);
+    gb->cpu.cycles += 1;
 }
 
-static inline void xfe_cp_d8(emu_cpu *cpu) {
-    cp_8(cpu->reg.a, read_d8(cpu));
-    cpu->cycles += 2;
+static inline void xfb_ei(gb_instance *gb) {
+    gb->cpu.cycles += 1;
+    interrupt_ei(gb);
 }
 
-static inline void xff_rst_38h(emu_cpu *cpu) {
-    push_16(cpu, cpu->reg.pc);
-    cpu->reg.pc = 0x0038;
-    cpu->cycles += 4;
+static inline void xfe_cp_d8(gb_instance *gb) {
+    cp_8(gb, gb->cpu.reg.a, read_d8(gb));
+    gb->cpu.cycles += 2;
 }
 
+static inline void xff_rst_38h(gb_instance *gb) {
+    gb->cpu.cycles += 2;
+    push_16(gb, gb->cpu.reg.pc);
+    gb->cpu.reg.pc = 0x0038;
+    CALLSTACK_ENTER(gb, 0x0038, CALLSTACK_CALL);
+}
+
+/**
+CB-prefixed instructions. Every (operation, operand, bit) gets its own
+handler, so the bit index and the register are constants in the body.
+Operand order in each row of 8: B C D E H L (HL) A.
+*/
+#define CB_DEFINE_REG(name, op, r)                           \
+    static inline void cb_##name##_##r(gb_instance *gb) {   \
+        gb->cpu.reg.r = op(gb, gb->cpu.reg.r);              \
+        gb->cpu.cycles += 2;                                 \
+    }
+
+#define CB_DEFINE_MHL(name, op)                              \
+    static inline void cb_##name##_mhl(gb_instance *gb) {   \
+        gb->cpu.cycles += 2;                                 \
+        uint8_t data = mem_read(gb, gb->cpu.reg.hl);         \
+        gb->cpu.cycles += 1;                                 \
+        mem_write(gb, gb->cpu.reg.hl, op(gb, data));         \
+        gb->cpu.cycles += 1;                                 \
+    }
+
+#define CB_DEFINE_ROW(name)                                  \
+    CB_DEFINE_REG(name, name##_8, b)                         \
+    CB_DEFINE_REG(name, name##_8, c)                         \
+    CB_DEFINE_REG(name, name##_8, d)                         \
+    CB_DEFINE_REG(name, name##_8, e)                         \
+    CB_DEFINE_REG(name, name##_8, h)                         \
+    CB_DEFINE_REG(name, name##_8, l)                         \
+    CB_DEFINE_MHL(name, name##_8)                            \
+    CB_DEFINE_REG(name, name##_8, a)
+
+#define CB_DEFINE_BIT_REG(n, r)                                         \
+    static inline void cb_bit_##n##_##r(gb_instance *gb) {             \
+        bit_8(gb, gb->cpu.reg.r, 1 << n);                               \
+        gb->cpu.cycles += 2;                                            \
+    }                                                                   \
+    static inline void cb_res_##n##_##r(gb_instance *gb) {             \
+        gb->cpu.reg.r &= (uint8_t)~(1 << n);                            \
+        gb->cpu.cycles += 2;                                            \
+    }                                                                   \
+    static inline void cb_set_##n##_##r(gb_instance *gb) {             \
+        gb->cpu.reg.r |= (uint8_t)(1 << n);                             \
+        gb->cpu.cycles += 2;                                            \
+    }
+
+#define CB_DEFINE_BIT_MHL(n)                                            \
+    static inline void cb_bit_##n##_mhl(gb_instance *gb) {             \
+        gb->cpu.cycles += 2;                                            \
+        bit_8(gb, mem_read(gb, gb->cpu.reg.hl), 1 << n);                \
+        gb->cpu.cycles += 1;                                            \
+    }                                                                   \
+    static inline void cb_res_##n##_mhl(gb_instance *gb) {             \
+        gb->cpu.cycles += 2;                                            \
+        uint8_t data = mem_read(gb, gb->cpu.reg.hl);                    \
+        gb->cpu.cycles += 1;                                            \
+        mem_write(gb, gb->cpu.reg.hl, data & (uint8_t)~(1 << n));       \
+        gb->cpu.cycles += 1;                                            \
+    }                                                                   \
+    static inline void cb_set_##n##_mhl(gb_instance *gb) {             \
+        gb->cpu.cycles += 2;                                            \
+        uint8_t data = mem_read(gb, gb->cpu.reg.hl);                    \
+        gb->cpu.cycles += 1;                                            \
+        mem_write(gb, gb->cpu.reg.hl, data | (uint8_t)(1 << n));        \
+        gb->cpu.cycles += 1;                                            \
+    }
+
+#define CB_DEFINE_BIT(n)                                     \
+    CB_DEFINE_BIT_REG(n, b)                                  \
+    CB_DEFINE_BIT_REG(n, c)                                  \
+    CB_DEFINE_BIT_REG(n, d)                                  \
+    CB_DEFINE_BIT_REG(n, e)                                  \
+    CB_DEFINE_BIT_REG(n, h)                                  \
+    CB_DEFINE_BIT_REG(n, l)                                  \
+    CB_DEFINE_BIT_MHL(n)                                     \
+    CB_DEFINE_BIT_REG(n, a)
+
+CB_DEFINE_ROW(rlc)
+CB_DEFINE_ROW(rrc)
+CB_DEFINE_ROW(rl)
+CB_DEFINE_ROW(rr)
+CB_DEFINE_ROW(sla)
+CB_DEFINE_ROW(sra)
+CB_DEFINE_ROW(swap)
+CB_DEFINE_ROW(srl)
+CB_DEFINE_BIT(0)
+CB_DEFINE_BIT(1)
+CB_DEFINE_BIT(2)
+CB_DEFINE_BIT(3)
+CB_DEFINE_BIT(4)
+CB_DEFINE_BIT(5)
+CB_DEFINE_BIT(6)
+CB_DEFINE_BIT(7)
+
 // clang-format off
-const instruction_func_t instruction_set[16][16] = {
-    x00_nop, x01_ld_bc_d16, x02_ld_mbc_a, x03_inc_bc, x04_inc_b, x05_dec_b, x06_ld_b_d8, x00_nop, x08_ld_a16_sp, x09_add_hl_bc, x0a_ld_a_mbc, x0b_dec_bc, x0c_inc_c, x0d_dec_c, x0e_ld_c_d8, x00_nop,
-    x00_nop, x11_ld_de_d16, x12_ld_mde_a, x13_inc_de, x14_inc_d, x15_dec_d, x16_ld_d_d8, x00_nop, x18_jr_r8, x19_add_hl_de, x1a_ld_a_mde, x1b_dec_de, x1c_inc_e, x1d_dec_e, x1e_ld_e_d8, x00_nop,
-    x20_jr_nz_r8, x21_ld_hl_d16, x22_ldi_mhl_a, x23_inc_hl, x24_inc_h, x25_dec_h, x26_ld_h_d8, x27_daa, x28_jr_z_r8, x29_add_hl_hl, x2a_ldi_a_mhl, x2b_dec_hl, x2c_inc_l, x2d_dec_l, x2e_ld_l_d8, x2f_cpl,
-    x30_jr_nc_r8, x31_ld_sp_d16, x32_ldd_mhl_a, x33_inc_sp, x34_inc_mhl, x35_dec_mhl, x36_ld_mhl_d8, x37_scf, x38_jr_c_r8, x39_add_hl_sp, x3a_ldd_a_mhl, x3b_dec_sp, x3c_inc_a, x3d_dec_a, x3e_ld_a_d8, x3f_ccf,
-    x40_ld_b_b, x41_ld_b_c, x42_ld_b_d, x43_ld_b_e, x44_ld_b_h, x45_ld_b_l, x46_ld_b_mhl, x47_ld_b_a, x48_ld_c_b, x49_ld_c_c, x4a_ld_c_d, x4b_ld_c_e, x4c_ld_c_h, x4d_ld_c_l, x4e_ld_c_mhl, x4f_ld_c_a,
-    x50_ld_d_b, x51_ld_d_c, x52_ld_d_d, x53_ld_d_e, x54_ld_d_h, x55_ld_d_l, x56_ld_d_mhl, x57_ld_d_a, x58_ld_e_b, x59_ld_e_c, x5a_ld_e_d, x5b_ld_e_e, x5c_ld_e_h, x5d_ld_e_l, x5e_ld_e_mhl, x5f_ld_e_a,
-    x60_ld_h_b, x61_ld_h_c, x62_ld_h_d, x63_ld_h_e, x64_ld_h_h, x65_ld_h_l, x66_ld_h_mhl, x67_ld_h_a, x68_ld_l_b, x69_ld_l_c, x6a_ld_l_d, x6b_ld_l_e, x6c_ld_l_h, x6d_ld_l_l, x6e_ld_l_mhl, x6f_ld_l_a,
-    x70_ld_mhl_b, x71_ld_mhl_c, x72_ld_mhl_d, x73_ld_mhl_e, x74_ld_mhl_h, x75_ld_mhl_l, x00_nop, x77_ld_mhl_a, x78_ld_a_b, x79_ld_a_c, x7a_ld_a_d, x7b_ld_a_e, x7c_ld_a_h, x7d_ld_a_l, x7e_ld_a_mhl, x7f_ld_a_a,
-    x80_add_a_b, x81_add_a_c, x82_add_a_d, x83_add_a_e, x84_add_a_h, x85_add_a_l, x86_add_a_mhl, x87_add_a_a, x88_adc_a_b, x89_adc_a_c, x8a_adc_a_d, x8b_adc_a_e, x8c_adc_a_h, x8d_adc_a_l, x8e_adc_a_mhl, x8f_adc_a_a,
-    x90_sub_b, x91_sub_c, x92_sub_d, x93_sub_e, x94_sub_h, x95_sub_l, x96_sub_mhl, x97_sub_a, x98_sbc_a_b, x99_sbc_a_c, x9a_sbc_a_d, x9b_sbc_a_e, x9c_sbc_a_h, x9d_sbc_a_l, x9e_sbc_a_mhl, x9f_sbc_a_a,
-    xa0_and_b, xa1_and_c, xa2_and_d, xa3_and_e, xa4_and_h, xa5_and_l, xa6_and_mhl, xa7_and_a, xa8_xor_b, xa9_xor_c, xaa_xor_d, xab_xor_e, xac_xor_h, xad_xor_l, xae_xor_mhl, xaf_xor_a,
-    xb0_or_b, xb1_or_c, xb2_or_d, xb3_or_e, xb4_or_h, xb5_or_l, xb6_or_mhl, xb7_or_a, xb8_cp_b, xb9_cp_c, xba_cp_d, xbb_cp_e, xbc_cp_h, xbd_cp_l, xbe_cp_mhl, xbf_cp_a,
-    xc0_ret_nz, xc1_pop_bc, xc2_jp_nz_a16, xc3_jp_a16, xc4_call_nz_a16, xc5_push_bc, xc6_add_a_d8, xc7_rst_00h, xc8_ret_z, xc9_ret, xca_jp_z_a16, x00_nop, xcc_call_z_a16, xcd_call_a16, xce_adc_a_d8, xcf_rst_08h,
-    xd0_ret_nc, xd1_pop_de, xd2_jp_nc_a16, x00_nop, xd4_call_nc_a16, xd5_push_de, xd6_sub_d8, xd7_rst_10h, xd8_ret_c, xd9_reti, xda_jp_c_a16, x00_nop, xdc_call_c_a16, x00_nop, xde_sbc_a_d8, xdf_rst_18h,
-    xe0_ldh_m8_a, xe1_pop_hl, xe2_ld_mc_a, x00_nop, x00_nop, xe5_push_hl, xe6_and_d8, xe7_rst_20h, xe8_add_sp_r8, xe9_jp_hl, xea_ld_a16_a, x00_nop, x00_nop, x00_nop, xee_xor_d8, xef_rst_28h,
-    xf0_ldh_a_m8, xf1_pop_af, xf2_ld_a_mc, x00_nop, x00_nop, xf5_push_af, xf6_or_d8, xf7_rst_30h, xf8_ld_hl_sp_r8, xf9_ld_sp_hl, xfa_ld_a_a16, x00_nop, x00_nop, x00_nop, xfe_cp_d8, xff_rst_38h,
+#define CB_ROW(X, base, name) \
+    X((base) + 0, cb_##name##_b) X((base) + 1, cb_##name##_c) X((base) + 2, cb_##name##_d) X((base) + 3, cb_##name##_e) \
+    X((base) + 4, cb_##name##_h) X((base) + 5, cb_##name##_l) X((base) + 6, cb_##name##_mhl) X((base) + 7, cb_##name##_a)
+
+#define CB_BIT_ROWS(X, base, name) \
+    CB_ROW(X, (base) + 0x00, name##_0) CB_ROW(X, (base) + 0x08, name##_1) \
+    CB_ROW(X, (base) + 0x10, name##_2) CB_ROW(X, (base) + 0x18, name##_3) \
+    CB_ROW(X, (base) + 0x20, name##_4) CB_ROW(X, (base) + 0x28, name##_5) \
+    CB_ROW(X, (base) + 0x30, name##_6) CB_ROW(X, (base) + 0x38, name##_7)
+
+#define CB_INSTRUCTION_LIST(X) \
+    CB_ROW(X, 0x00, rlc) CB_ROW(X, 0x08, rrc) CB_ROW(X, 0x10, rl)   CB_ROW(X, 0x18, rr) \
+    CB_ROW(X, 0x20, sla) CB_ROW(X, 0x28, sra) CB_ROW(X, 0x30, swap) CB_ROW(X, 0x38, srl) \
+    CB_BIT_ROWS(X, 0x40, bit) CB_BIT_ROWS(X, 0x80, res) CB_BIT_ROWS(X, 0xC0, set)
+// clang-format on
+
+#ifndef GB_HANDLERS_ONLY
+#define TABLE_ENTRY(code, func) [(code) >> 4][(code) & 0x0F] = func,
+const instruction_func_t cb_instruction_set[16][16] = {
+    CB_INSTRUCTION_LIST(TABLE_ENTRY)
 };
+#undef TABLE_ENTRY
+#endif
+
+// the CB switch compiles to one jump table with every handler expanded in place
+static inline void xcb_prefix(gb_instance *gb) {
+    switch (read_d8(gb)) {
+#define SWITCH_CASE(code, func) case code: func(gb); break;
+        CB_INSTRUCTION_LIST(SWITCH_CASE)
+#undef SWITCH_CASE
+    }
+}
+
+/**
+ * Superinstructions, see decode_fused. On entry pc already points past the
+ * first instruction and imm holds its operand. Each body runs the original
+ * handlers back to back, so flags and cycle counts are those of the unfused
+ * sequence, but it costs one dispatch and the compiler can keep A and the
+ * lazy flag bytes in registers from one step to the next. Nothing checks
+ * run_deadline inside a body: fetch_dispatch only picks one when its worst
+ * case (last column of FUSED_LIST) fits before the deadline, and a body
+ * going on after a store stops there if the store broke the engine (an
+ * IE/IF write raising an interrupt). The precise build never uses them.
+ */
+static inline void fused_ldi_a_mhl_ld_mde_a(gb_instance *gb) {
+    x2a_ldi_a_mhl(gb);
+    x12_ld_mde_a(gb);
+    gb->cpu.reg.pc += 1;
+}
+
+static inline void fused_copy_hli_to_de(gb_instance *gb) {
+    x2a_ldi_a_mhl(gb);
+    x12_ld_mde_a(gb);
+    gb->cpu.reg.pc += 1;
+    if (gb->cpu.cycles >= gb->run_deadline) {
+        return ;
+    }
+    x13_inc_de(gb);
+    gb->cpu.reg.pc += 1;
+}
+
+static inline void fused_copy_de_to_hli(gb_instance *gb) {
+    x1a_ld_a_mde(gb);
+    x22_ldi_mhl_a(gb);
+    gb->cpu.reg.pc += 1;
+    if (gb->cpu.cycles >= gb->run_deadline) {
+        return ;
+    }
+    x13_inc_de(gb);
+    gb->cpu.reg.pc += 1;
+}
+
+// the JR operand comes from imm_fused, pc has to point past the JR before it runs
+#define FUSED_DEC_JR_NZ(r, dec)                               \
+    static inline void fused_dec_##r##_jr_nz(gb_instance *gb) { \
+        dec(gb);                                              \
+        gb->cpu.reg.pc += 2;                                  \
+        gb->cpu.imm = gb->cpu.imm_fused;                      \
+        x20_jr_nz_r8(gb);                                     \
+    }
+
+FUSED_DEC_JR_NZ(b, x05_dec_b)
+FUSED_DEC_JR_NZ(c, x0d_dec_c)
+FUSED_DEC_JR_NZ(d, x15_dec_d)
+FUSED_DEC_JR_NZ(e, x1d_dec_e)
+FUSED_DEC_JR_NZ(a, x3d_dec_a)
+
+static inline void fused_dec_bc_jr_nz(gb_instance *gb) {
+    x0b_dec_bc(gb);
+    x78_ld_a_b(gb);
+    xb1_or_c(gb);
+    gb->cpu.reg.pc += 4;
+    gb->cpu.imm = gb->cpu.imm_fused;
+    x20_jr_nz_r8(gb);
+}
+
+// imm_fused holds the CP operand in the low byte and the JR offset in the high byte
+static inline void fused_ldh_cp_jr_nz(gb_instance *gb) {
+    xf0_ldh_a_m8(gb);
+    gb->cpu.reg.pc += 2;
+    gb->cpu.imm = gb->cpu.imm_fused & 0xFF;
+    xfe_cp_d8(gb);
+    gb->cpu.reg.pc += 2;
+    gb->cpu.imm = gb->cpu.imm_fused >> 8;
+    x20_jr_nz_r8(gb);
+}
+
+static inline void fused_ldh_cp_jr_z(gb_instance *gb) {
+    xf0_ldh_a_m8(gb);
+    gb->cpu.reg.pc += 2;
+    gb->cpu.imm = gb->cpu.imm_fused & 0xFF;
+    xfe_cp_d8(gb);
+    gb->cpu.reg.pc += 2;
+    gb->cpu.imm = gb->cpu.imm_fused >> 8;
+    x28_jr_z_r8(gb);
+}
+
+// imm_fused is the loop's length in bytes, pc is moved back to its head before it runs
+static inline void fused_idle_loop(gb_instance *gb) {
+    uint16_t loop = gb->cpu.reg.pc - instruction_length[gb->cpu.opcode];
+    idle_loop_run(gb, loop, loop + gb->cpu.imm_fused);
+}
+
+// id, handler, worst-case M-cycles (branches taken); the idle loop keeps to run_deadline itself
+// clang-format off
+#define FUSED_LIST(X) \
+    X(FUSED_LDI_A_MHL_LD_MDE_A, fused_ldi_a_mhl_ld_mde_a, 4) X(FUSED_COPY_HLI_TO_DE, fused_copy_hli_to_de, 6) \
+    X(FUSED_COPY_DE_TO_HLI, fused_copy_de_to_hli, 6) X(FUSED_DEC_B_JR_NZ, fused_dec_b_jr_nz, 4) \
+    X(FUSED_DEC_C_JR_NZ, fused_dec_c_jr_nz, 4) X(FUSED_DEC_D_JR_NZ, fused_dec_d_jr_nz, 4) \
+    X(FUSED_DEC_E_JR_NZ, fused_dec_e_jr_nz, 4) X(FUSED_DEC_A_JR_NZ, fused_dec_a_jr_nz, 4) \
+    X(FUSED_DEC_BC_JR_NZ, fused_dec_bc_jr_nz, 7) X(FUSED_LDH_CP_JR_NZ, fused_ldh_cp_jr_nz, 8) \
+    X(FUSED_LDH_CP_JR_Z, fused_ldh_cp_jr_z, 8) X(FUSED_IDLE_LOOP, fused_idle_loop, 0)
 // clang-format on
+
+// Every opcode and its handler, in opcode order. All dispatch engines below
+// are generated from this one list so they can never disagree.
+// clang-format off
+#define INSTRUCTION_LIST(X) \
+    X(0x00, x00_nop) X(0x01, x01_ld_bc_d16) X(0x02, x02_ld_mbc_a) X(0x03, x03_inc_bc) X(0x04, x04_inc_b) X(0x05, x05_dec_b) X(0x06, x06_ld_b_d8) X(0x07, x07_rlca) X(0x08, x08_ld_a16_sp) X(0x09, x09_add_hl_bc) X(0x0A, x0a_ld_a_mbc) X(0x0B, x0b_dec_bc) X(0x0C, x0c_inc_c) X(0x0D, x0d_dec_c) X(0x0E, x0e_ld_c_d8) X(0x0F, x0f_rrca) \
+    X(0x10, x10_stop) X(0x11, x11_ld_de_d16) X(0x12, x12_ld_mde_a) X(0x13, x13_inc_de) X(0x14, x14_inc_d) X(0x15, x15_dec_d) X(0x16, x16_ld_d_d8) X(0x17, x17_rla) X(0x18, x18_jr_r8) X(0x19, x19_add_hl_de) X(0x1A, x1a_ld_a_mde) X(0x1B, x1b_dec_de) X(0x1C, x1c_inc_e) X(0x1D, x1d_dec_e) X(0x1E, x1e_ld_e_d8) X(0x1F, x1f_rra) \
+    X(0x20, x20_jr_nz_r8) X(0x21, x21_ld_hl_d16) X(0x22, x22_ldi_mhl_a) X(0x23, x23_inc_hl) X(0x24, x24_inc_h) X(0x25, x25_dec_h) X(0x26, x26_ld_h_d8) X(0x27, x27_daa) X(0x28, x28_jr_z_r8) X(0x29, x29_add_hl_hl) X(0x2A, x2a_ldi_a_mhl) X(0x2B, x2b_dec_hl) X(0x2C, x2c_inc_l) X(0x2D, x2d_dec_l) X(0x2E, x2e_ld_l_d8) X(0x2F, x2f_cpl) \
+    X(0x30, x30_jr_nc_r8) X(0x31, x31_ld_sp_d16) X(0x32, x32_ldd_mhl_a) X(0x33, x33_inc_sp) X(0x34, x34_inc_mhl) X(0x35, x35_dec_mhl) X(0x36, x36_ld_mhl_d8) X(0x37, x37_scf) X(0x38, x38_jr_c_r8) X(0x39, x39_add_hl_sp) X(0x3A, x3a_ldd_a_mhl) X(0x3B, x3b_dec_sp) X(0x3C, x3c_inc_a) X(0x3D, x3d_dec_a) X(0x3E, x3e_ld_a_d8) X(0x3F, x3f_ccf) \
+    X(0x40, x40_ld_b_b) X(0x41, x41_ld_b_c) X(0x42, x42_ld_b_d) X(0x43, x43_ld_b_e) X(0x44, x44_ld_b_h) X(0x45, x45_ld_b_l) X(0x46, x46_ld_b_mhl) X(0x47, x47_ld_b_a) X(0x48, x48_ld_c_b) X(0x49, x49_ld_c_c) X(0x4A, x4a_ld_c_d) X(0x4B, x4b_ld_c_e) X(0x4C, x4c_ld_c_h) X(0x4D, x4d_ld_c_l) X(0x4E, x4e_ld_c_mhl) X(0x4F, x4f_ld_c_a) \
+    X(0x50, x50_ld_d_b) X(0x51, x51_ld_d_c) X(0x52, x52_ld_d_d) X(0x53, x53_ld_d_e) X(0x54, x54_ld_d_h) X(0x55, x55_ld_d_l) X(0x56, x56_ld_d_mhl) X(0x57, x57_ld_d_a) X(0x58, x58_ld_e_b) X(0x59, x59_ld_e_c) X(0x5A, x5a_ld_e_d) X(0x5B, x5b_ld_e_e) X(0x5C, x5c_ld_e_h) X(0x5D, x5d_ld_e_l) X(0x5E, x5e_ld_e_mhl) X(0x5F, x5f_ld_e_a) \
+    X(0x60, x60_ld_h_b) X(0x61, x61_ld_h_c) X(0x62, x62_ld_h_d) X(0x63, x63_ld_h_e) X(0x64, x64_ld_h_h) X(0x65, x65_ld_h_l) X(0x66, x66_ld_h_mhl) X(0x67, x67_ld_h_a) X(0x68, x68_ld_l_b) X(0x69, x69_ld_l_c) X(0x6A, x6a_ld_l_d) X(0x6B, x6b_ld_l_e) X(0x6C, x6c_ld_l_h) X(0x6D, x6d_ld_l_l) X(0x6E, x6e_ld_l_mhl) X(0x6F, x6f_ld_l_a) \
+    X(0x70, x70_ld_mhl_b) X(0x71, x71_ld_mhl_c) X(0x72, x72_ld_mhl_d) X(0x73, x73_ld_mhl_e) X(0x74, x74_ld_mhl_h) X(0x75, x75_ld_mhl_l) X(0x76, x76_halt) X(0x77, x77_ld_mhl_a) X(0x78, x78_ld_a_b) X(0x79, x79_ld_a_c) X(0x7A, x7a_ld_a_d) X(0x7B, x7b_ld_a_e) X(0x7C, x7c_ld_a_h) X(0x7D, x7d_ld_a_l) X(0x7E, x7e_ld_a_mhl) X(0x7F, x7f_ld_a_a) \
+    X(0x80, x80_add_a_b) X(0x81, x81_add_a_c) X(0x82, x82_add_a_d) X(0x83, x83_add_a_e) X(0x84, x84_add_a_h) X(0x85, x85_add_a_l) X(0x86, x86_add_a_mhl) X(0x87, x87_add_a_a) X(0x88, x88_adc_a_b) X(0x89, x89_adc_a_c) X(0x8A, x8a_adc_a_d) X(0x8B, x8b_adc_a_e) X(0x8C, x8c_adc_a_h) X(0x8D, x8d_adc_a_l) X(0x8E, x8e_adc_a_mhl) X(0x8F, x8f_adc_a_a) \
+    X(0x90, x90_sub_b) X(0x91, x91_sub_c) X(0x92, x92_sub_d) X(0x93, x93_sub_e) X(0x94, x94_sub_h) X(0x95, x95_sub_l) X(0x96, x96_sub_mhl) X(0x97, x97_sub_a) X(0x98, x98_sbc_a_b) X(0x99, x99_sbc_a_c) X(0x9A, x9a_sbc_a_d) X(0x9B, x9b_sbc_a_e) X(0x9C, x9c_sbc_a_h) X(0x9D, x9d_sbc_a_l) X(0x9E, x9e_sbc_a_mhl) X(0x9F, x9f_sbc_a_a) \
+    X(0xA0, xa0_and_b) X(0xA1, xa1_and_c) X(0xA2, xa2_and_d) X(0xA3, xa3_and_e) X(0xA4, xa4_and_h) X(0xA5, xa5_and_l) X(0xA6, xa6_and_mhl) X(0xA7, xa7_and_a) X(0xA8, xa8_xor_b) X(0xA9, xa9_xor_c) X(0xAA, xaa_xor_d) X(0xAB, xab_xor_e) X(0xAC, xac_xor_h) X(0xAD, xad_xor_l) X(0xAE, xae_xor_mhl) X(0xAF, xaf_xor_a) \
+    X(0xB0, xb0_or_b) X(0xB1, xb1_or_c) X(0xB2, xb2_or_d) X(0xB3, xb3_or_e) X(0xB4, xb4_or_h) X(0xB5, xb5_or_l) X(0xB6, xb6_or_mhl) X(0xB7, xb7_or_a) X(0xB8, xb8_cp_b) X(0xB9, xb9_cp_c) X(0xBA, xba_cp_d) X(0xBB, xbb_cp_e) X(0xBC, xbc_cp_h) X(0xBD, xbd_cp_l) X(0xBE, xbe_cp_mhl) X(0xBF, xbf_cp_a) \
+    X(0xC0, xc0_ret_nz) X(0xC1, xc1_pop_bc) X(0xC2, xc2_jp_nz_a16) X(0xC3, xc3_jp_a16) X(0xC4, xc4_call_nz_a16) X(0xC5, xc5_push_bc) X(0xC6, xc6_add_a_d8) X(0xC7, xc7_rst_00h) X(0xC8, xc8_ret_z) X(0xC9, xc9_ret) X(0xCA, xca_jp_z_a16) X(0xCB, xcb_prefix) X(0xCC, xcc_call_z_a16) X(0xCD, xcd_call_a16) X(0xCE, xce_adc_a_d8) X(0xCF, xcf_rst_08h) \
+    X(0xD0, xd0_ret_nc) X(0xD1, xd1_pop_de) X(0xD2, xd2_jp_nc_a16) X(0xD3, x00_nop) X(0xD4, xd4_call_nc_a16) X(0xD5, xd5_push_de) X(0xD6, xd6_sub_d8) X(0xD7, xd7_rst_10h) X(0xD8, xd8_ret_c) X(0xD9, xd9_reti) X(0xDA, xda_jp_c_a16) X(0xDB, x00_nop) X(0xDC, xdc_call_c_a16) X(0xDD, x00_nop) X(0xDE, xde_sbc_a_d8) X(0xDF, xdf_rst_18h) \
+    X(0xE0, xe0_ldh_m8_a) X(0xE1, xe1_pop_hl) X(0xE2, xe2_ld_mc_a) X(0xE3, x00_nop) X(0xE4, x00_nop) X(0xE5, xe5_push_hl) X(0xE6, xe6_and_d8) X(0xE7, xe7_rst_20h) X(0xE8, xe8_add_sp_r8) X(0xE9, xe9_jp_hl) X(0xEA, xea_ld_a16_a) X(0xEB, x00_nop) X(0xEC, x00_nop) X(0xED, x00_nop) X(0xEE, xee_xor_d8) X(0xEF, xef_rst_28h) \
+    X(0xF0, xf0_ldh_a_m8) X(0xF1, xf1_pop_af) X(0xF2, xf2_ld_a_mc) X(0xF3, xf3_di) X(0xF4, x00_nop) X(0xF5, xf5_push_af) X(0xF6, xf6_or_d8) X(0xF7, xf7_rst_30h) X(0xF8, xf8_ld_hl_sp_r8) X(0xF9, xf9_ld_sp_hl) X(0xFA, xfa_ld_a_a16) X(0xFB, xfb_ei) X(0xFC, x00_nop) X(0xFD, x00_nop) X(0xFE, xfe_cp_d8) X(0xFF, xff_rst_38h)
+// clang-format on
+
+// gb_staticrec output includes this file with GB_HANDLERS_ONLY to inline the handlers
+// above; the tables and engines below then come from gb_core instead
+#ifndef GB_HANDLERS_ONLY
+#define TABLE_ENTRY(code, func) [(code) >> 4][(code) & 0x0F] = func,
+const instruction_func_t instruction_set[16][16] = {
+    INSTRUCTION_LIST(TABLE_ENTRY)
+};
+#undef TABLE_ENTRY
+
+static inline decoded_instruction *decode_lookup(gb_instance *gb, uint16_t pc) {
+    decoded_instruction *bank;
+
+    if (pc <= 0x3FFF) {
+        bank = gb->decode.rom[0];
+    } else if (pc <= 0x7FFF) {
+        bank = gb->decode.rom[gb->cart.rom_bank % DECODE_ROM_BANKS];
+        pc -= 0x4000;
+    } else if (pc >= 0xC000 && pc <= 0xDFFF) {
+        bank = gb->decode.wram;
+        pc -= 0xC000;
+    } else if (pc >= 0xFF80 && pc <= 0xFFFE) {
+        return &gb->decode.hram[pc - 0xFF80];
+    } else {
+        return NULL;
+    }
+
+    return bank ? &bank[pc] : NULL;
+}
+
+// a cache hit costs one lookup; misses and uncacheable regions go through decode_fill
+static inline decoded_instruction *fetch_entry(gb_instance *gb, uint16_t pc) {
+    decoded_instruction *entry = decode_lookup(gb, pc);
+
+    if (entry == NULL || entry->length == 0) {
+        entry = decode_fill(gb, pc, entry);
+    }
+    return entry;
+}
+
+// engine dispatch index: the opcode, or 256 + decode_fused id when a superinstruction starts here
+#define DISPATCH_SIZE (256 + FUSED_COUNT)
+
+#ifdef GB_TIMING_PRECISE
+/**
+ * Every instruction byte is fetched on its own M-cycle, after the events due
+ * by then. While an OAM DMA holds the bus the bytes come from bus_read and
+ * its conflict path instead of the decode cache. cpu.cycles is handed back
+ * at the opcode fetch (plus whatever an event stalled the CPU for), the
+ * handler counts the fetch cycles itself.
+ */
+static inline uint8_t fetch_opcode(gb_instance *gb) {
+    emu_cpu *cpu = &gb->cpu;
+    uint16_t pc = cpu->reg.pc;
+    decoded_instruction *entry = NULL;
+
+    mem_sync(gb);
+    if (gb->oam_dma.active) {
+        cpu->opcode = bus_read(gb, pc);
+        cpu->imm = 0;
+    } else {
+        entry = fetch_entry(gb, pc);
+        cpu->opcode = entry->opcode;
+        cpu->imm = entry->operand;
+    }
+
+    uint8_t length = instruction_length[cpu->opcode];
+    for (uint8_t i = 1; i < length; i++) {
+        cpu->cycles += 1;
+        mem_sync(gb);
+        if (entry == NULL || gb->oam_dma.active) {
+            uint8_t shift = (i - 1) * 8;
+            cpu->imm = (uint16_t)((cpu->imm & ~(0xFF << shift)) | bus_read(gb, pc + i) << shift);
+        }
+    }
+    cpu->cycles -= length - 1;
+
+    cpu->reg.pc = pc + length;
+    return cpu->opcode;
+}
+
+// the precise build never runs superinstructions
+static inline uint16_t fetch_dispatch(gb_instance *gb) {
+    return fetch_opcode(gb);
+}
+#else
+static inline uint8_t fetch_opcode(gb_instance *gb) {
+    emu_cpu *cpu = &gb->cpu;
+    decoded_instruction *entry = fetch_entry(gb, cpu->reg.pc);
+
+    cpu->imm = entry->operand;
+    cpu->reg.pc += entry->length;
+    cpu->opcode = entry->opcode;
+    return entry->opcode;
+}
+
+#ifdef GB_FUSION
+#define FUSED_CYCLES_ENTRY(id, func, cycles) [id] = cycles,
+static const uint8_t fused_cycles[FUSED_COUNT] = {
+    FUSED_LIST(FUSED_CYCLES_ENTRY)
+};
+#undef FUSED_CYCLES_ENTRY
+#endif
+
+static inline uint16_t fetch_dispatch(gb_instance *gb) {
+    emu_cpu *cpu = &gb->cpu;
+    decoded_instruction *entry = fetch_entry(gb, cpu->reg.pc);
+
+    cpu->imm = entry->operand;
+    cpu->reg.pc += entry->length;
+    cpu->opcode = entry->opcode;
+#ifdef GB_FUSION
+    // otherwise the first instruction runs on its own, the engine checks the deadline after it
+    if (entry->fused != FUSED_NONE && cpu->cycles + fused_cycles[entry->fused] <= gb->run_deadline) {
+        cpu->imm_fused = entry->fused_operand;
+        return 256 + entry->fused;
+    }
+#endif
+    return entry->opcode;
+}
+#endif
+
+#define DISPATCH_ENTRY(code, func) [code] = func,
+#define DISPATCH_FUSED_ENTRY(id, func, cycles) [256 + (id)] = func,
+static const instruction_func_t dispatch_set[DISPATCH_SIZE] = {
+    INSTRUCTION_LIST(DISPATCH_ENTRY)
+    FUSED_LIST(DISPATCH_FUSED_ENTRY)
+};
+#undef DISPATCH_FUSED_ENTRY
+#undef DISPATCH_ENTRY
+
+void instructions_step(gb_instance *gb) {
+    uint16_t pc = gb->cpu.reg.pc;
+    uint8_t opcode = fetch_opcode(gb);
+    TRACE_INSTR(gb, pc);
+    instruction_set[opcode >> 4][opcode & 0x0F](gb);
+}
+
+void instructions_run_table(gb_instance *gb) {
+    while (gb->cpu.cycles < gb->run_deadline) {
+        dispatch_set[fetch_dispatch(gb)](gb);
+    }
+}
+
+// instructions_precise.c only needs one engine
+#ifndef GB_TIMING_PRECISE
+// the handlers are static inline in this file, so every case is expanded in place
+void instructions_run_switch(gb_instance *gb) {
+    while (gb->cpu.cycles < gb->run_deadline) {
+        switch (fetch_dispatch(gb)) {
+#define SWITCH_CASE(code, func) case code: func(gb); break;
+#define SWITCH_FUSED_CASE(id, func, cycles) case 256 + (id): func(gb); break;
+            INSTRUCTION_LIST(SWITCH_CASE)
+            FUSED_LIST(SWITCH_FUSED_CASE)
+#undef SWITCH_FUSED_CASE
+#undef SWITCH_CASE
+        }
+    }
+}
+
+#ifdef GB_HAVE_COMPUTED_GOTO
+// threaded interpreter: each handler body ends in its own indirect jump to the next one
+void instructions_run_goto(gb_instance *gb) {
+#define GOTO_LABEL(code, func) [code] = &&op_##code,
+#define GOTO_FUSED_LABEL(id, func, cycles) [256 + (id)] = &&fused_##id,
+    static const void *const labels[DISPATCH_SIZE] = {
+        INSTRUCTION_LIST(GOTO_LABEL)
+        FUSED_LIST(GOTO_FUSED_LABEL)
+    };
+#undef GOTO_FUSED_LABEL
+#undef GOTO_LABEL
+
+#define DISPATCH()                                 \
+    do {                                           \
+        if (gb->cpu.cycles >= gb->run_deadline) {  \
+            return;                                \
+        }                                          \
+        goto *labels[fetch_dispatch(gb)];          \
+    } while (0)
+
+    DISPATCH();
+
+#define GOTO_BODY(code, func) op_##code: func(gb); DISPATCH();
+#define GOTO_FUSED_BODY(id, func, cycles) fused_##id: func(gb); DISPATCH();
+    INSTRUCTION_LIST(GOTO_BODY)
+    FUSED_LIST(GOTO_FUSED_BODY)
+#undef GOTO_FUSED_BODY
+#undef GOTO_BODY
+#undef DISPATCH
+}
+#endif
+
+#if defined(GB_PROFILE) || GB_TRACE_LEVEL >= TRACE_LEVEL_INSTR
+#ifdef GB_PROFILE
+#define NAME_ENTRY(code, func) [code] = #func,
+#define CB_NAME_ENTRY(code, func) [0x100 + (code)] = #func,
+const char *const instruction_names[PROFILE_OPCODES] = {
+    INSTRUCTION_LIST(NAME_ENTRY)
+    CB_INSTRUCTION_LIST(CB_NAME_ENTRY)
+};
+#undef CB_NAME_ENTRY
+#undef NAME_ENTRY
+#endif
+
+// one real opcode per dispatch, so fused sequences are counted and traced as their parts
+void instructions_run_instrumented(gb_instance *gb) {
+#ifdef GB_PROFILE
+    profile_data *p = &gb->profile;
+#endif
+
+    while (gb->cpu.cycles < gb->run_deadline) {
+        uint16_t pc = gb->cpu.reg.pc;
+        uint8_t opcode = fetch_opcode(gb);
+        instruction_func_t handler = instruction_set[opcode >> 4][opcode & 0x0F];
+
+        TRACE_INSTR(gb, pc);
+#ifdef GB_PROFILE
+        uint64_t start = gb->cpu.cycles;
+        uint16_t key = profile_key(opcode, gb->cpu.imm);
+
+        if (gb->hotspot.coverage != NULL) {
+            hotspot_mark(gb, pc);
+        }
+        if (profile_should_sample(p)) {
+            uint64_t t = profile_now();
+            handler(gb);
+            profile_sample(p, key, profile_now() - t);
+        } else {
+            handler(gb);
+        }
+        profile_count(p, key, gb->cpu.cycles - start);
+#else
+        handler(gb);
+#endif
+    }
+}
+#endif
+#endif
+
+#endif
@@ -0,0 +1,14 @@
+/**
+ * The M-cycle accurate build of the handlers in instructions.c. The same
+ * source is compiled a second time with GB_TIMING_PRECISE, so mem_read and
+ * mem_write run the scheduler events due by then before every access, and
+ * the exported tables and engine get a _precise name. Used when an instance
+ * is set to GB_ACCURACY_PRECISE.
+ */
+#define GB_TIMING_PRECISE
+#define instruction_set instruction_set_precise
+#define cb_instruction_set cb_instruction_set_precise
+#define instructions_step instructions_step_precise
+#define instructions_run_table instructions_run_precise
+
+#include "instructions.c"
@@ -0,0 +1,147 @@
+#include "interrupt.h"
+#include "gb.h"
+#include "bus.h"
+#include "decode.h"
+#include "instructions.h"
+#include "io.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// lowest set bit of a 5-bit IE & IF mask, which is the interrupt to take
+static const uint8_t lowest_bit[32] = {
+    0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+};
+
+// FF0F and FFFF, the unused IF bits come from the I/O read mask
+static uint8_t interrupt_read(gb_instance *gb, uint16_t addr) {
+    return addr == 0xFFFF ? gb->irq.ie : gb->irq.flags;
+}
+
+static void interrupt_write(gb_instance *gb, uint16_t addr, uint8_t data) {
+    if (addr == 0xFFFF) {
+        gb->irq.ie = data;
+    } else {
+        gb->irq.flags = data & INT_MASK;
+    }
+    interrupt_update(gb);
+}
+
+void interrupt_init(gb_instance *gb) {
+    gb->irq.ie = 0x00;
+    gb->irq.flags = INT_VBLANK; // IF reads 0xE1 after the boot rom
+    gb->irq.ime = false;
+    gb->irq.deferred = 0;
+    interrupt_update(gb);
+
+    io_set_handler(gb, 0xFF0F, interrupt_read, interrupt_write);
+    io_set_handler(gb, 0xFFFF, interrupt_read, interrupt_write);
+}
+
+void interrupt_update(gb_instance *gb) {
+    gb->irq.active = gb->irq.ie & gb->irq.flags & INT_MASK;
+    gb->irq.pending = gb->irq.ime && gb->irq.active;
+    if (gb->irq.pending) {
+        gb_break_engine(gb);
+    }
+}
+
+void interrupt_request(gb_instance *gb, uint8_t mask) {
+    gb->irq.flags |= mask & INT_MASK;
+    interrupt_update(gb);
+}
+
+void interrupt_ei(gb_instance *gb) {
+    gb->irq.deferred |= IRQ_DEFER_EI;
+    gb_break_engine(gb);
+}
+
+void interrupt_di(gb_instance *gb) {
+    gb->irq.deferred &= ~IRQ_DEFER_EI;
+    interrupt_set_ime(gb, false);
+}
+
+void interrupt_halt(gb_instance *gb) {
+    if (!gb->irq.ime && gb->irq.active) {
+        gb->irq.deferred |= IRQ_DEFER_HALT_BUG; // the CPU never sleeps, but pc sticks once
+    } else {
+        gb->cpu.halted = true;
+    }
+    gb_break_engine(gb);
+}
+
+void interrupt_set_ime(gb_instance *gb, bool ime) {
+    gb->irq.ime = ime;
+    interrupt_update(gb);
+}
+
+/**
+ * Take the highest priority interrupt: clear its IF bit and IME, push pc and
+ * jump to the vector. 5 M-cycles.
+ */
+void interrupt_service(gb_instance *gb) {
+    uint8_t bit = lowest_bit[gb->irq.active];
+    uint16_t pc = gb->cpu.reg.pc;
+
+    TRACE_EVENT(gb, TRACE_KIND_IRQ, pc, 0x40 + bit * 8);
+    gb->irq.flags &= ~(1 << bit);
+    gb->irq.ime = false;
+    interrupt_update(gb);
+
+    // two wait cycles, the pushes in M2 and M3, the jump in M4
+    gb->cpu.cycles += 2;
+    gb->cpu.reg.sp -= 2;
+    bus_write(gb, gb->cpu.reg.sp + 1, (uint8_t)(pc >> 8));
+    gb->cpu.cycles += 1;
+    bus_write(gb, gb->cpu.reg.sp, (uint8_t)(pc & 0xFF));
+    gb->cpu.cycles += 2;
+    gb->cpu.reg.pc = 0x40 + bit * 8;
+    CALLSTACK_ENTER(gb, gb->cpu.reg.pc, CALLSTACK_IRQ);
+}
+
+// The byte after HALT is fetched as the opcode without pc moving on, so the
+// operand starts at the opcode itself and a 1-byte instruction runs twice.
+static void halt_bug_step(gb_instance *gb) {
+    uint16_t pc = gb->cpu.reg.pc;
+    uint8_t opcode = bus_read(gb, pc);
+    uint8_t length = instruction_length[opcode];
+    uint16_t operand = 0;
+
+    if (length >= 2) {
+        operand = bus_read(gb, pc);
+    }
+    if (length == 3) {
+        operand |= (uint16_t)bus_read(gb, pc + 1) << 8;
+    }
+
+    gb->cpu.imm = operand;
+    gb->cpu.opcode = opcode;
+    gb->cpu.reg.pc = pc + length - 1;
+    if (gb->accuracy == GB_ACCURACY_PRECISE) {
+        instruction_set_precise[opcode >> 4][opcode & 0x0F](gb);
+    } else {
+        instruction_set[opcode >> 4][opcode & 0x0F](gb);
+    }
+}
+
+// Runs the one instruction an EI delay or the HALT bug needs outside the engine.
+// gb_run_until only calls it while the CPU is awake.
+void interrupt_deferred_step(gb_instance *gb) {
+    uint8_t deferred = gb->irq.deferred;
+
+    gb->irq.deferred &= ~IRQ_DEFER_HALT_BUG;
+    if (deferred & IRQ_DEFER_HALT_BUG) {
+        halt_bug_step(gb);
+    } else if (gb->accuracy == GB_ACCURACY_PRECISE) {
+        instructions_step_precise(gb);
+    } else {
+        instructions_step(gb);
+    }
+
+    // a DI in between cancels it
+    if ((deferred & IRQ_DEFER_EI) && (gb->irq.deferred & IRQ_DEFER_EI)) {
+        gb->irq.deferred &= ~IRQ_DEFER_EI;
+        interrupt_set_ime(gb, true);
+    }
+}
@@ -0,0 +1,130 @@
+#include "io.h"
+#include "gb.h"
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    uint16_t addr;
+    uint8_t read_mask;
+    uint8_t write_mask;
+    uint8_t value; // after the boot rom
+} io_default;
+
+// everything not listed reads 0xFF and ignores writes
+static const io_default io_defaults[] = {
+    {0xFF00, 0xC0, 0x30, 0x0F}, // P1/JOYP, no button pressed
+    {0xFF01, 0x00, 0xFF, 0x00}, // SB
+    {0xFF02, 0x7E, 0x81, 0x00}, // SC
+    {0xFF04, 0x00, 0xFF, 0xAB}, // DIV
+    {0xFF05, 0x00, 0xFF, 0x00}, // TIMA
+    {0xFF06, 0x00, 0xFF, 0x00}, // TMA
+    {0xFF07, 0xF8, 0x07, 0x00}, // TAC
+    {0xFF0F, 0xE0, 0x1F, 0x01}, // IF
+    {0xFF10, 0x80, 0x7F, 0x00}, // NR10
+    {0xFF11, 0x3F, 0xFF, 0x80}, // NR11, length is write-only
+    {0xFF12, 0x00, 0xFF, 0xF3}, // NR12
+    {0xFF13, 0xFF, 0xFF, 0x00}, // NR13, write-only
+    {0xFF14, 0xBF, 0xC7, 0x00}, // NR14
+    {0xFF16, 0x3F, 0xFF, 0x00}, // NR21
+    {0xFF17, 0x00, 0xFF, 0x00}, // NR22
+    {0xFF18, 0xFF, 0xFF, 0x00}, // NR23
+    {0xFF19, 0xBF, 0xC7, 0x00}, // NR24
+    {0xFF1A, 0x7F, 0x80, 0x00}, // NR30
+    {0xFF1B, 0xFF, 0xFF, 0x00}, // NR31
+    {0xFF1C, 0x9F, 0x60, 0x00}, // NR32
+    {0xFF1D, 0xFF, 0xFF, 0x00}, // NR33
+    {0xFF1E, 0xBF, 0xC7, 0x00}, // NR34
+    {0xFF20, 0xFF, 0x3F, 0x00}, // NR41
+    {0xFF21, 0x00, 0xFF, 0x00}, // NR42
+    {0xFF22, 0x00, 0xFF, 0x00}, // NR43
+    {0xFF23, 0xBF, 0xC0, 0x00}, // NR44
+    {0xFF24, 0x00, 0xFF, 0x77}, // NR50
+    {0xFF25, 0x00, 0xFF, 0xF3}, // NR51
+    {0xFF26, 0x70, 0x80, 0xF1}, // NR52, channel status bits are read-only
+    {0xFF40, 0x00, 0xFF, 0x91}, // LCDC
+    {0xFF41, 0x80, 0x78, 0x05}, // STAT, mode and coincidence bits are read-only
+    {0xFF42, 0x00, 0xFF, 0x00}, // SCY
+    {0xFF43, 0x00, 0xFF, 0x00}, // SCX
+    {0xFF44, 0x00, 0x00, 0x00}, // LY
+    {0xFF45, 0x00, 0xFF, 0x00}, // LYC
+    {0xFF46, 0x00, 0xFF, 0xFF}, // DMA
+    {0xFF47, 0x00, 0xFF, 0xFC}, // BGP
+    {0xFF48, 0x00, 0xFF, 0xFF}, // OBP0
+    {0xFF49, 0x00, 0xFF, 0xFF}, // OBP1
+    {0xFF4A, 0x00, 0xFF, 0x00}, // WY
+    {0xFF4B, 0x00, 0xFF, 0x00}, // WX
+    {0xFFFF, 0x00, 0xFF, 0x00}, // IE
+};
+
+// only present in CGB mode
+static const io_default io_defaults_cgb[] = {
+    {0xFF4D, 0x7E, 0x01, 0x00}, // KEY1
+    {0xFF4F, 0xFE, 0x01, 0x00}, // VBK
+    {0xFF51, 0xFF, 0xFF, 0x00}, // HDMA1, HDMA1-4 are write-only
+    {0xFF52, 0xFF, 0xFF, 0x00}, // HDMA2
+    {0xFF53, 0xFF, 0xFF, 0x00}, // HDMA3
+    {0xFF54, 0xFF, 0xFF, 0x00}, // HDMA4
+    {0xFF55, 0x00, 0xFF, 0xFF}, // HDMA5
+    {0xFF56, 0x3C, 0xC1, 0x00}, // RP
+    {0xFF68, 0x40, 0xBF, 0x00}, // BCPS
+    {0xFF69, 0x00, 0xFF, 0x00}, // BCPD
+    {0xFF6A, 0x40, 0xBF, 0x00}, // OCPS
+    {0xFF6B, 0x00, 0xFF, 0x00}, // OCPD
+    {0xFF70, 0xF8, 0x07, 0x00}, // SVBK
+};
+
+static void io_load(io_ports *io, const io_default *defaults, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t index = io_index(defaults[i].addr);
+        io->read_mask[index] = defaults[i].read_mask;
+        io->write_mask[index] = defaults[i].write_mask;
+        io->value[index] = defaults[i].value;
+    }
+}
+
+void io_init(gb_instance *gb) {
+    io_ports *io = &gb->io;
+
+    memset(io, 0, sizeof(io_ports));
+    memset(io->read_mask, 0xFF, sizeof(io->read_mask));
+
+    io_load(io, io_defaults, sizeof(io_defaults) / sizeof(io_defaults[0]));
+    if (gb->cgb) {
+        io_load(io, io_defaults_cgb, sizeof(io_defaults_cgb) / sizeof(io_defaults_cgb[0]));
+    }
+
+    // wave RAM
+    for (uint16_t addr = 0xFF30; addr <= 0xFF3F; addr++) {
+        io->read_mask[io_index(addr)] = 0x00;
+        io->write_mask[io_index(addr)] = 0xFF;
+    }
+}
+
+void io_set_handler(gb_instance *gb, uint16_t addr, io_read_callback read, io_write_callback write) {
+    uint8_t index = io_index(addr);
+
+    gb->io.read[index] = read;
+    gb->io.write[index] = write;
+}
+
+uint8_t io_read(gb_instance *gb, uint16_t addr) {
+    io_ports *io = &gb->io;
+    uint8_t index = io_index(addr);
+
+    if (io->read[index] != NULL) {
+        return io->read[index](gb, addr) | io->read_mask[index];
+    }
+    return io->value[index] | io->read_mask[index];
+}
+
+void io_write(gb_instance *gb, uint16_t addr, uint8_t data) {
+    io_ports *io = &gb->io;
+    uint8_t index = io_index(addr);
+    uint8_t mask = io->write_mask[index];
+
+    io->value[index] = (io->value[index] & ~mask) | (data & mask);
+    if (io->write[index] != NULL) {
+        io->write[index](gb, addr, io->value[index]);
+    }
+}
@@ -0,0 +1,663 @@
+#include "jit.h"
+#include "gb.h"
+#include "decode.h"
+#include "instructions.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef GB_HAVE_JIT
+
+#include <string.h>
+#include <sys/mman.h>
+
+/**
+ * Basic-block recompiler for x86-64 hosts.
+ *
+ * A block is the straight run of guest instructions from an entry pc up to
+ * the first jump/call/return (or HALT, STOP, EI, DI). Register moves,
+ * immediate loads, 16-bit INC/DEC and JP/JR are emitted as native stores
+ * into gb_instance. Everything else becomes a direct call to its interpreter
+ * handler, so flags and memory side effects come from the same code the
+ * interpreter runs. The generated code keeps gb in rbx for the whole run.
+ *
+ * A block only starts when its worst case (every branch taken) fits before
+ * run_deadline, otherwise jit_run steps the interpreter, so events and
+ * interrupts are taken on the same instruction as in the other engines. A
+ * store in the middle of a ROM block is followed by a run_deadline check,
+ * since an IE/IF write can raise an interrupt there.
+ *
+ * Blocks with a fixed successor end in a chain slot. The slot jumps to a
+ * stub that hands the slot address back to jit_run. Once the successor is
+ * compiled, jit_run patches the slot to jump straight into it, together
+ * with the successor's worst case, which the slot checks against
+ * run_deadline first. Slots whose target is in 4000-7FFF also compare
+ * rom_bank.
+ *
+ * Blocks built from WRAM/HRAM end after any store. bus_write drops them as
+ * soon as one of their bytes changes. Nothing chains into them, so dropping
+ * one only means removing it from the lookup table.
+ */
+
+#define JIT_CODE_SIZE   (4 << 20)
+#define JIT_BLOCK_CODE  8192   // worst case for one block, checked before compiling
+#define JIT_MAX_BLOCKS  16384
+#define JIT_HASH_SIZE   4096
+#define JIT_BLOCK_LIMIT 64     // guest instructions per block
+#define JIT_RAM_BANK    0xFFFF // bank part of the key for WRAM/HRAM blocks
+#define JIT_SLOT_CYCLES 18     // a chain slot's successor cycles sit this many bytes before its link
+
+typedef struct jit_block {
+    uint32_t key;       // bank << 16 | start address
+    uint16_t start;
+    uint16_t end;       // one past the last guest byte
+    uint16_t count;     // guest instructions, all of them run unless a store breaks the engine
+    uint16_t cycles;    // worst case for one run, every branch taken
+    uint8_t in_ram;
+    uint8_t *code;
+    struct jit_block *next;     // hash chain
+    struct jit_block *ram_next; // list of live RAM blocks
+} jit_block;
+
+/**
+ * Everything a block can change, rolled back before the interpreter replays
+ * it in JIT_VERIFY mode, so stores to I/O (an OAM DMA start, a sched_add)
+ * happen once per run. The decode cache and the profiling and trace state
+ * are not part of it: the replay redoes the same invalidations, and counts
+ * and records the block a second time.
+ */
+typedef struct {
+    emu_cpu cpu;
+    emu_bus bus;
+    emu_cart cart; // bank state, the cart has no RAM of its own yet
+    interrupt_ctrl irq;
+    io_ports io;
+    scheduler sched;
+    uint64_t next_event;
+    uint64_t run_deadline;
+    oam_dma_state oam_dma;
+    hdma_state hdma;
+} jit_snapshot;
+
+typedef uint8_t *(*jit_enter_func)(gb_instance *gb, uint8_t *code);
+
+struct jit_state {
+    jit_mode mode;
+    jit_stats stats;
+
+    uint8_t *code;
+    uint32_t code_used;
+    jit_enter_func enter;
+
+    jit_block *blocks;
+    uint32_t block_count;
+    jit_block *hash[JIT_HASH_SIZE];
+    jit_block *ram_blocks;
+
+    jit_snapshot *before;
+    jit_snapshot *after;
+};
+
+#define OFF(field) ((int32_t)offsetof(gb_instance, field))
+
+// B C D E H L (HL) A, the usual 3-bit register encoding
+static const int32_t reg8_offset[8] = {
+    OFF(cpu.reg.b), OFF(cpu.reg.c), OFF(cpu.reg.d), OFF(cpu.reg.e),
+    OFF(cpu.reg.h), OFF(cpu.reg.l), -1, OFF(cpu.reg.a),
+};
+
+// BC DE HL SP
+static const int32_t reg16_offset[4] = {
+    OFF(cpu.reg.bc), OFF(cpu.reg.de), OFF(cpu.reg.hl), OFF(cpu.reg.sp),
+};
+
+/* ---------- x86-64 emitter, every memory operand is [rbx + disp32] ---------- */
+
+static inline void emit8(uint8_t **p, uint8_t v) {
+    *(*p)++ = v;
+}
+
+static inline void emit16(uint8_t **p, uint16_t v) {
+    memcpy(*p, &v, 2);
+    *p += 2;
+}
+
+static inline void emit32(uint8_t **p, uint32_t v) {
+    memcpy(*p, &v, 4);
+    *p += 4;
+}
+
+static inline void emit64(uint8_t **p, uint64_t v) {
+    memcpy(*p, &v, 8);
+    *p += 8;
+}
+
+static inline void emit_rel32(uint8_t **p, const uint8_t *target) {
+    emit32(p, (uint32_t)(int32_t)(target - (*p + 4)));
+}
+
+// mov word [rbx + off], imm16
+static void emit_store16(uint8_t **p, int32_t off, uint16_t v) {
+    emit8(p, 0x66); emit8(p, 0xC7); emit8(p, 0x83);
+    emit32(p, (uint32_t)off);
+    emit16(p, v);
+}
+
+// mov byte [rbx + off], imm8
+static void emit_store8(uint8_t **p, int32_t off, uint8_t v) {
+    emit8(p, 0xC6); emit8(p, 0x83);
+    emit32(p, (uint32_t)off);
+    emit8(p, v);
+}
+
+// mov al, [rbx + src]; mov [rbx + dst], al
+static void emit_move8(uint8_t **p, int32_t dst, int32_t src) {
+    emit8(p, 0x8A); emit8(p, 0x83);
+    emit32(p, (uint32_t)src);
+    emit8(p, 0x88); emit8(p, 0x83);
+    emit32(p, (uint32_t)dst);
+}
+
+// inc/dec word [rbx + off]
+static void emit_incdec16(uint8_t **p, int32_t off, bool dec) {
+    emit8(p, 0x66); emit8(p, 0xFF); emit8(p, dec ? 0x8B : 0x83);
+    emit32(p, (uint32_t)off);
+}
+
+// add qword [rbx + cycles], n
+static void emit_cycles(uint8_t **p, uint32_t *pending) {
+    if (*pending == 0) {
+        return ;
+    }
+
+    emit8(p, 0x48); emit8(p, 0x81); emit8(p, 0x83);
+    emit32(p, (uint32_t)OFF(cpu.cycles));
+    emit32(p, *pending);
+    *pending = 0;
+}
+
+// mov rdi, rbx; mov rax, func; call rax
+static void emit_call(uint8_t **p, instruction_func_t func) {
+    emit8(p, 0x48); emit8(p, 0x89); emit8(p, 0xDF);
+    emit8(p, 0x48); emit8(p, 0xB8);
+    emit64(p, (uint64_t)(uintptr_t)func);
+    emit8(p, 0xFF); emit8(p, 0xD0);
+}
+
+// xor eax, eax; pop rbx; ret -- back to jit_run with nothing to link
+static void emit_exit(uint8_t **p) {
+    emit8(p, 0x31); emit8(p, 0xC0);
+    emit8(p, 0x5B);
+    emit8(p, 0xC3);
+}
+
+// mov rax, [rbx + cycles]; cmp rax, [rbx + run_deadline]; jae exit -- after a store that may break the engine
+static void emit_deadline_exit(uint8_t **p, uint8_t *exit) {
+    emit8(p, 0x48); emit8(p, 0x8B); emit8(p, 0x83);
+    emit32(p, (uint32_t)OFF(cpu.cycles));
+    emit8(p, 0x48); emit8(p, 0x3B); emit8(p, 0x83);
+    emit32(p, (uint32_t)OFF(run_deadline));
+    emit8(p, 0x0F); emit8(p, 0x83);
+    emit_rel32(p, exit);
+}
+
+/**
+ * Chain slot towards a fixed guest target. Until jit_run patches the jmp,
+ * it lands on a stub returning the address of its rel32 field. The
+ * successor's cycles are patched in JIT_SLOT_CYCLES bytes before it.
+ */
+static void emit_slot(gb_instance *gb, uint8_t **p, uint8_t *exit, uint16_t target) {
+    if (target >= 0x4000 && target <= 0x7FFF) {
+        // cmp word [rbx + rom_bank], bank; jne exit
+        emit8(p, 0x66); emit8(p, 0x81); emit8(p, 0xBB);
+        emit32(p, (uint32_t)OFF(cart.rom_bank));
+        emit16(p, gb->cart.rom_bank);
+        emit8(p, 0x0F); emit8(p, 0x85);
+        emit_rel32(p, exit);
+    }
+
+    // mov rax, [rbx + cycles]; add rax, successor cycles; cmp rax, [rbx + run_deadline]; ja exit
+    emit8(p, 0x48); emit8(p, 0x8B); emit8(p, 0x83);
+    emit32(p, (uint32_t)OFF(cpu.cycles));
+    emit8(p, 0x48); emit8(p, 0x05);
+    emit32(p, 0);
+    emit8(p, 0x48); emit8(p, 0x3B); emit8(p, 0x83);
+    emit32(p, (uint32_t)OFF(run_deadline));
+    emit8(p, 0x0F); emit8(p, 0x87);
+    emit_rel32(p, exit);
+
+    // jmp stub; stub: mov rax, link; pop rbx; ret
+    emit8(p, 0xE9);
+    uint8_t *link = *p;
+    emit32(p, 0);
+    memcpy(link, &(int32_t){ (int32_t)(*p - (link + 4)) }, 4);
+
+    emit8(p, 0x48); emit8(p, 0xB8);
+    emit64(p, (uint64_t)(uintptr_t)link);
+    emit8(p, 0x5B);
+    emit8(p, 0xC3);
+}
+
+/* ---------- block lookup ---------- */
+
+static bool jit_key(gb_instance *gb, uint16_t pc, uint32_t *key) {
+    if (pc <= 0x3FFF) {
+        *key = pc;
+    } else if (pc <= 0x7FFF) {
+        *key = ((uint32_t)gb->cart.rom_bank << 16) | pc;
+    } else if ((pc >= 0xC000 && pc <= 0xDFFF) || (pc >= 0xFF80 && pc <= 0xFFFE)) {
+        *key = ((uint32_t)JIT_RAM_BANK << 16) | pc;
+    } else {
+        return false; // VRAM, cart RAM, echo, OAM, I/O: left to the interpreter
+    }
+
+    return true;
+}
+
+static inline uint32_t jit_hash(uint32_t key) {
+    return (key ^ (key >> 14)) & (JIT_HASH_SIZE - 1);
+}
+
+static jit_block *jit_lookup(struct jit_state *jit, uint32_t key) {
+    for (jit_block *block = jit->hash[jit_hash(key)]; block != NULL; block = block->next) {
+        if (block->key == key) {
+            return block;
+        }
+    }
+
+    return NULL;
+}
+
+static void jit_unlink(struct jit_state *jit, jit_block *block) {
+    jit_block **slot = &jit->hash[jit_hash(block->key)];
+
+    while (*slot != block) {
+        slot = &(*slot)->next;
+    }
+    *slot = block->next;
+}
+
+static void jit_flush(struct jit_state *jit) {
+    memset(jit->hash, 0, sizeof(jit->hash));
+    jit->ram_blocks = NULL;
+    jit->block_count = 0;
+    jit->code_used = 0;
+    jit->stats.flushes++;
+}
+
+/* ---------- compiler ---------- */
+
+static uint8_t *jit_emit_enter(struct jit_state *jit) {
+    uint8_t *p = jit->code;
+
+    // push rbx; mov rbx, rdi; jmp rsi
+    emit8(&p, 0x53);
+    emit8(&p, 0x48); emit8(&p, 0x89); emit8(&p, 0xFB);
+    emit8(&p, 0xFF); emit8(&p, 0xE6);
+
+    jit->code_used = (uint32_t)(p - jit->code);
+    return jit->code;
+}
+
+static jit_block *jit_compile(gb_instance *gb, uint32_t key) {
+    struct jit_state *jit = gb->jit;
+    uint16_t pc = (uint16_t)key;
+    bool in_ram = (key >> 16) == JIT_RAM_BANK;
+
+    if (jit->block_count == JIT_MAX_BLOCKS || jit->code_used + JIT_BLOCK_CODE > JIT_CODE_SIZE) {
+        jit_flush(jit);
+        jit_emit_enter(jit);
+    }
+
+    uint8_t *p = jit->code + jit->code_used;
+    uint8_t *exit = p;
+    emit_exit(&p);
+
+    jit_block *block = &jit->blocks[jit->block_count++];
+    block->key = key;
+    block->start = pc;
+    block->count = 0;
+    block->cycles = 0;
+    block->in_ram = in_ram;
+    block->code = p;
+
+    uint16_t addr = pc;
+    uint32_t pending = 0;
+
+    for (;;) {
+        decoded_instruction *entry = decode_fill(gb, addr, NULL);
+        uint8_t op = entry->opcode;
+        uint16_t imm = entry->operand;
+        uint16_t next = (uint16_t)(addr + entry->length);
+        uint16_t target = 0;
+        decode_flow flow = decode_flow_of(entry, addr, &target);
+        block->count++;
+        block->cycles += entry->cycles + decode_taken_cycles(op);
+        block->end = next;
+
+        if (op == 0x00) {
+            pending += entry->cycles;
+        } else if (op >= 0x40 && op <= 0x7F && (op & 0x07) != 0x06 && ((op >> 3) & 0x07) != 0x06) {
+            emit_move8(&p, reg8_offset[(op >> 3) & 0x07], reg8_offset[op & 0x07]);
+            pending += entry->cycles;
+        } else if (op <= 0x3F && (op & 0x07) == 0x06 && op != 0x36) {
+            emit_store8(&p, reg8_offset[op >> 3], (uint8_t)imm);
+            pending += entry->cycles;
+        } else if (op <= 0x3F && (op & 0x0F) == 0x01) {
+            emit_store16(&p, reg16_offset[op >> 4], imm);
+            pending += entry->cycles;
+        } else if (op <= 0x3F && ((op & 0x0F) == 0x03 || (op & 0x0F) == 0x0B)) {
+            emit_incdec16(&p, reg16_offset[op >> 4], (op & 0x0F) == 0x0B);
+            pending += entry->cycles;
+        } else if (op == 0xC3 || op == 0x18) {
+            emit_store16(&p, OFF(cpu.reg.pc), target);
+            pending += entry->cycles;
+            emit_cycles(&p, &pending);
+            emit_slot(gb, &p, exit, target);
+            break;
+        } else {
+            emit_cycles(&p, &pending);
+            emit_store16(&p, OFF(cpu.reg.pc), next);
+            if (op == 0xCB) {
+                emit_call(&p, cb_instruction_set[(imm >> 4) & 0x0F][imm & 0x0F]);
+            } else {
+                if (entry->length > 1) {
+                    emit_store16(&p, OFF(cpu.imm), imm);
+                }
+                emit_call(&p, instruction_set[op >> 4][op & 0x0F]);
+            }
+            // RAM blocks end after a store anyway, see below
+            if (flow == FLOW_NEXT && !in_ram && decode_writes_memory(op, (uint8_t)imm)) {
+                emit_deadline_exit(&p, exit);
+            }
+        }
+
+        if (flow != FLOW_NEXT) {
+            emit_cycles(&p, &pending);
+            if (flow == FLOW_JUMP || flow == FLOW_CALL) {
+                emit_slot(gb, &p, exit, target);
+            } else if (flow == FLOW_BRANCH) {
+                // cmp word [rbx + pc], target; jne not_taken
+                emit8(&p, 0x66); emit8(&p, 0x81); emit8(&p, 0xBB);
+                emit32(&p, (uint32_t)OFF(cpu.reg.pc));
+                emit16(&p, target);
+                emit8(&p, 0x0F); emit8(&p, 0x85);
+                uint8_t *not_taken = p;
+                emit32(&p, 0);
+
+                emit_slot(gb, &p, exit, target);
+                memcpy(not_taken, &(int32_t){ (int32_t)(p - (not_taken + 4)) }, 4);
+                emit_slot(gb, &p, exit, next);
+            } else {
+                // RET, JP HL, HALT, ...: the successor is only known at run time
+                emit_exit(&p);
+            }
+            break;
+        }
+
+        // the next block starts where this one would cross into another region
+        bool boundary = next == 0x4000 || next == 0x8000 || next == 0xE000 || next == 0xFFFF ||
+                        next < addr || block->count == JIT_BLOCK_LIMIT;
+        // RAM blocks stop after a store so they never run bytes it just changed
+        if (in_ram && decode_writes_memory(op, (uint8_t)imm)) {
+            // stores always go through a handler call, which already left pc at next
+            emit_cycles(&p, &pending);
+            emit_exit(&p);
+            break;
+        }
+        if (boundary) {
+            emit_cycles(&p, &pending);
+            emit_store16(&p, OFF(cpu.reg.pc), next);
+            emit_slot(gb, &p, exit, next);
+            break;
+        }
+
+        addr = next;
+    }
+
+    jit->code_used = (uint32_t)(p - jit->code);
+
+    block->next = jit->hash[jit_hash(key)];
+    jit->hash[jit_hash(key)] = block;
+    if (in_ram) {
+        block->ram_next = jit->ram_blocks;
+        jit->ram_blocks = block;
+    }
+
+    jit->stats.blocks_compiled++;
+    return block;
+}
+
+/* ---------- verification ---------- */
+
+static void jit_save(gb_instance *gb, jit_snapshot *snap) {
+    snap->cpu = gb->cpu;
+    snap->bus = gb->bus;
+    snap->cart = gb->cart;
+    snap->irq = gb->irq;
+    snap->io = gb->io;
+    snap->sched = gb->sched;
+    snap->next_event = gb->next_event;
+    snap->run_deadline = gb->run_deadline;
+    snap->oam_dma = gb->oam_dma;
+    snap->hdma = gb->hdma;
+}
+
+static void jit_restore(gb_instance *gb, const jit_snapshot *snap) {
+    gb->cpu = snap->cpu;
+    gb->bus = snap->bus;
+    gb->cart = snap->cart;
+    gb->irq = snap->irq;
+    gb->io = snap->io;
+    gb->sched = snap->sched;
+    gb->next_event = snap->next_event;
+    gb->run_deadline = snap->run_deadline;
+    gb->oam_dma = snap->oam_dma;
+    gb->hdma = snap->hdma;
+    bus_map_reset(gb); // ROM, VRAM and WRAM banks may have moved
+}
+
+static bool jit_same_sched(const scheduler *a, const scheduler *b) {
+    for (int event = 0; event < SCHED_EVENT_COUNT; event++) {
+        if ((a->pos[event] < 0) != (b->pos[event] < 0) || (a->pos[event] >= 0 && a->when[event] != b->when[event])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool jit_same(gb_instance *gb, jit_snapshot *snap) {
+    emu_cpu *a = &gb->cpu;
+    emu_cpu *b = &snap->cpu;
+    interrupt_ctrl *irq = &snap->irq;
+
+    return a->reg.af == b->reg.af && a->reg.bc == b->reg.bc && a->reg.de == b->reg.de &&
+           a->reg.hl == b->reg.hl && a->reg.sp == b->reg.sp && a->reg.pc == b->reg.pc &&
+           flags_pack(a) == flags_pack(b) && a->cycles == b->cycles && a->halted == b->halted &&
+           gb->cart.rom_bank == snap->cart.rom_bank &&
+           memcmp(&gb->bus, &snap->bus, sizeof(emu_bus)) == 0 &&
+           gb->irq.ie == irq->ie && gb->irq.flags == irq->flags && gb->irq.ime == irq->ime &&
+           gb->irq.deferred == irq->deferred &&
+           memcmp(gb->io.value, snap->io.value, sizeof(gb->io.value)) == 0 &&
+           jit_same_sched(&gb->sched, &snap->sched) && gb->next_event == snap->next_event &&
+           gb->run_deadline == snap->run_deadline &&
+           gb->oam_dma.active == snap->oam_dma.active && gb->oam_dma.source == snap->oam_dma.source &&
+           gb->oam_dma.index == snap->oam_dma.index && gb->oam_dma.start == snap->oam_dma.start &&
+           gb->hdma.active == snap->hdma.active && gb->hdma.source == snap->hdma.source &&
+           gb->hdma.dest == snap->hdma.dest && gb->hdma.remaining == snap->hdma.remaining;
+}
+
+// the interpreter's result is kept either way, so a bad block cannot derail the run
+static void jit_verify(gb_instance *gb, jit_block *block) {
+    struct jit_state *jit = gb->jit;
+
+    jit_save(gb, jit->before);
+    jit->enter(gb, block->code);
+    jit_save(gb, jit->after);
+    jit_restore(gb, jit->before);
+
+    for (uint16_t i = 0; i < block->count; i++) {
+        instructions_step(gb);
+        // the block leaves early at the same point, see emit_deadline_exit
+        if (gb->cpu.cycles >= gb->run_deadline && decode_writes_memory(gb->cpu.opcode, (uint8_t)gb->cpu.imm)) {
+            break;
+        }
+    }
+
+    jit->stats.verified++;
+    if (!jit_same(gb, jit->after)) {
+        jit->stats.mismatches++;
+        jit->stats.mismatch_start = block->start;
+        jit->stats.mismatch_end = block->end;
+    }
+}
+
+/* ---------- public ---------- */
+
+void jit_run(gb_instance *gb) {
+    struct jit_state *jit = gb->jit;
+    uint8_t *link = NULL;
+
+    while (gb->cpu.cycles < gb->run_deadline && !gb->cpu.halted) {
+        uint32_t key;
+        jit_block *block = NULL;
+
+        if (jit_key(gb, gb->cpu.reg.pc, &key)) {
+            block = jit_lookup(jit, key);
+            if (block == NULL) {
+                uint64_t flushes = jit->stats.flushes;
+                block = jit_compile(gb, key);
+                if (jit->stats.flushes != flushes) {
+                    link = NULL; // the slot went away with the old code
+                }
+            }
+        }
+
+        // a block that could run past the deadline is left for the interpreter, one instruction at a time
+        if (block == NULL || gb->cpu.cycles + block->cycles > gb->run_deadline) {
+            instructions_step(gb);
+            jit->stats.interpreted++;
+            link = NULL;
+            continue;
+        }
+
+        if (jit->mode == JIT_VERIFY) {
+            jit_verify(gb, block);
+            continue;
+        }
+
+        if (link != NULL && !block->in_ram) {
+            int32_t rel = (int32_t)(block->code - (link + 4));
+            uint32_t cycles = block->cycles;
+            memcpy(link, &rel, 4);
+            memcpy(link - JIT_SLOT_CYCLES, &cycles, 4);
+        }
+
+        link = jit->enter(gb, block->code);
+    }
+}
+
+void jit_invalidate(gb_instance *gb, uint16_t addr) {
+    jit_invalidate_range(gb, addr, addr);
+}
+
+void jit_invalidate_range(gb_instance *gb, uint16_t first, uint16_t last) {
+    struct jit_state *jit = gb->jit;
+    jit_block **slot = &jit->ram_blocks;
+
+    while (*slot != NULL) {
+        jit_block *block = *slot;
+        if (block->start <= last && block->end > first) {
+            jit_unlink(jit, block);
+            *slot = block->ram_next;
+            jit->stats.invalidated++;
+        } else {
+            slot = &block->ram_next;
+        }
+    }
+}
+
+int jit_set_mode(gb_instance *gb, jit_mode mode) {
+    if (mode == JIT_OFF) {
+        jit_free(gb);
+        return 0;
+    }
+
+    if (gb->jit == NULL) {
+        struct jit_state *jit = (struct jit_state *)calloc(1, sizeof(struct jit_state));
+        if (jit == NULL) {
+            return 1;
+        }
+
+        jit->code = (uint8_t *)mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        jit->blocks = (jit_block *)malloc(JIT_MAX_BLOCKS * sizeof(jit_block));
+        jit->before = (jit_snapshot *)malloc(sizeof(jit_snapshot));
+        jit->after = (jit_snapshot *)malloc(sizeof(jit_snapshot));
+        gb->jit = jit;
+
+        if (jit->code == MAP_FAILED || jit->blocks == NULL || jit->before == NULL || jit->after == NULL) {
+            jit_free(gb);
+            return 1;
+        }
+
+        jit->enter = (jit_enter_func)(uintptr_t)jit_emit_enter(jit);
+    }
+
+    gb->jit->mode = mode;
+    return 0;
+}
+
+void jit_free(gb_instance *gb) {
+    struct jit_state *jit = gb->jit;
+    if (jit == NULL) {
+        return ;
+    }
+
+    if (jit->code != NULL && jit->code != MAP_FAILED) {
+        munmap(jit->code, JIT_CODE_SIZE);
+    }
+    free(jit->blocks);
+    free(jit->before);
+    free(jit->after);
+    free(jit);
+    gb->jit = NULL;
+}
+
+const jit_stats *jit_get_stats(gb_instance *gb) {
+    return gb->jit != NULL ? &gb->jit->stats : NULL;
+}
+
+#else
+
+int jit_set_mode(gb_instance *gb, jit_mode mode) {
+    (void)gb;
+    return mode == JIT_OFF ? 0 : 1;
+}
+
+void jit_free(gb_instance *gb) {
+    (void)gb;
+}
+
+void jit_run(gb_instance *gb) {
+    instructions_run(gb);
+}
+
+void jit_invalidate(gb_instance *gb, uint16_t addr) {
+    (void)gb;
+    (void)addr;
+}
+
+void jit_invalidate_range(gb_instance *gb, uint16_t first, uint16_t last) {
+    (void)gb;
+    (void)first;
+    (void)last;
+}
+
+const jit_stats *jit_get_stats(gb_instance *gb) {
+    (void)gb;
+    return NULL;
+}
+
+#endif
@@ -1,18 +1,82 @@
-#include "cart.h"
-#include "cpu.h"
-#include "bus.h"
+#include "gb.h"
 
-void emu_run() {
-    while (1) {
-        cpu_step();
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef GB_STATICREC
+// generated by gb_staticrec for the cartridge this binary was built for
+extern const staticrec_image gb_staticrec_image;
+#endif
+
+static volatile sig_atomic_t emu_quit;
+
+static void emu_on_signal(int sig) {
+    (void)sig;
+    emu_quit = 1;
+}
+
+void emu_run(gb_instance *gb) {
+    while (!emu_quit) {
+        gb_run_frame(gb);
     }
 }
 
+#ifdef GB_PROFILE
+// PC sampling interval in M-cycles, about 64 samples per frame
+#define EMU_HOTSPOT_INTERVAL 256
+
+// written on exit (Ctrl-C included), GB_PROFILE_CSV / GB_HOTSPOT_CSV / GB_CALLSTACK_FOLDED override the paths
+static void emu_write_profile(gb_instance *gb) {
+    const char *path = getenv("GB_PROFILE_CSV");
+    FILE *csv = fopen(path != NULL ? path : "gb_profile.csv", "w");
+    if (csv != NULL) {
+        profile_write_csv(gb, csv);
+        fclose(csv);
+    }
+
+    path = getenv("GB_HOTSPOT_CSV");
+    csv = fopen(path != NULL ? path : "gb_hotspot.csv", "w");
+    if (csv != NULL) {
+        hotspot_write_report(gb, csv, 64);
+        fclose(csv);
+    }
+
+    path = getenv("GB_CALLSTACK_FOLDED");
+    FILE *folded = fopen(path != NULL ? path : "gb_callstack.folded", "w");
+    if (folded != NULL) {
+        callstack_write_folded(gb, folded);
+        fclose(folded);
+    }
+}
+#endif
+
 int main() {
-    cart_init("pokemon.gbc");
-    mem_init();
-    cpu_init();
+    gb_instance *gb = gb_create("pokemon.gbc");
+    if (gb == NULL) {
+        return 1;
+    }
+    cart_print_header(gb);
+
+#ifdef GB_STATICREC
+    staticrec_attach(gb, &gb_staticrec_image);
+#endif
+
+#ifdef GB_PROFILE
+    hotspot_start(gb, EMU_HOTSPOT_INTERVAL, true);
+    callstack_start(gb);
+#endif
+#if GB_TRACE_LEVEL > TRACE_LEVEL_OFF
+    trace_install_crash_handler(gb, "gb_trace.bin");
+#endif
+    signal(SIGINT, emu_on_signal);
+    emu_run(gb);
+
+#ifdef GB_PROFILE
+    emu_write_profile(gb);
+#endif
 
-    emu_run();
+    gb_destroy(gb);
     return 0;
 }
@@ -0,0 +1,125 @@
+#ifdef GB_PROFILE
+
+#include "profile.h"
+#include "gb.h"
+#include "instructions.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *const class_names[PROFILE_CLASS_COUNT] = {
+    "ld8", "ld16", "alu8", "alu16", "branch", "stack", "cb", "control",
+};
+
+profile_class profile_class_of(uint16_t key) {
+    if (key >= 0x100) {
+        return PROFILE_CLASS_CB;
+    }
+
+    uint8_t op = (uint8_t)key;
+    uint8_t lo = op & 0x0F;
+
+    if (op == 0x76) {
+        return PROFILE_CLASS_CONTROL;
+    }
+    if (op >= 0x40 && op <= 0x7F) {
+        return PROFILE_CLASS_LD8;
+    }
+    if (op >= 0x80 && op <= 0xBF) {
+        return PROFILE_CLASS_ALU8;
+    }
+
+    if (op < 0x40) {
+        switch (lo) {
+        case 0x0:
+            return op <= 0x10 ? PROFILE_CLASS_CONTROL : PROFILE_CLASS_BRANCH; // NOP, STOP, JR cc
+        case 0x1:
+            return PROFILE_CLASS_LD16;
+        case 0x8:
+            return op == 0x08 ? PROFILE_CLASS_LD16 : PROFILE_CLASS_BRANCH; // LD (a16),SP, JR
+        case 0x2: case 0x6: case 0xA: case 0xE:
+            return PROFILE_CLASS_LD8;
+        case 0x3: case 0x9: case 0xB:
+            return PROFILE_CLASS_ALU16;
+        case 0x4: case 0x5: case 0xC: case 0xD: case 0x7: case 0xF:
+            return PROFILE_CLASS_ALU8;
+        }
+    }
+
+    switch (op) {
+    case 0xC1: case 0xC5: case 0xD1: case 0xD5: case 0xE1: case 0xE5: case 0xF1: case 0xF5:
+        return PROFILE_CLASS_STACK;
+    case 0xC6: case 0xCE: case 0xD6: case 0xDE: case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+        return PROFILE_CLASS_ALU8;
+    case 0xE0: case 0xF0: case 0xE2: case 0xF2: case 0xEA: case 0xFA:
+        return PROFILE_CLASS_LD8;
+    case 0xF8: case 0xF9:
+        return PROFILE_CLASS_LD16;
+    case 0xE8:
+        return PROFILE_CLASS_ALU16;
+    case 0xCB:
+        return PROFILE_CLASS_CB;
+    case 0xF3: case 0xFB:
+        return PROFILE_CLASS_CONTROL;
+    }
+
+    // what is left of C0-FF: JP, CALL, RET, RETI, RST, and the illegal opcodes
+    if (instruction_set[op >> 4][lo] == instruction_set[0][0]) {
+        return PROFILE_CLASS_CONTROL;
+    }
+    return PROFILE_CLASS_BRANCH;
+}
+
+void profile_sample(profile_data *p, uint16_t key, uint64_t ns) {
+    profile_class cls = profile_class_of(key);
+    p->class_ns[cls] += ns;
+    p->class_samples[cls]++;
+}
+
+void profile_reset(gb_instance *gb) {
+    memset(&gb->profile, 0, sizeof(gb->profile));
+}
+
+const profile_data *profile_get(gb_instance *gb) {
+    return &gb->profile;
+}
+
+uint64_t profile_class_ns(gb_instance *gb, profile_class cls) {
+    const profile_data *p = &gb->profile;
+    uint64_t executed = 0;
+
+    if (p->class_samples[cls] == 0) {
+        return 0;
+    }
+    for (uint16_t key = 0; key < PROFILE_OPCODES; key++) {
+        if (profile_class_of(key) == cls) {
+            executed += p->count[key];
+        }
+    }
+    return p->class_ns[cls] * executed / p->class_samples[cls];
+}
+
+const char *profile_class_name(profile_class cls) {
+    return cls < PROFILE_CLASS_COUNT ? class_names[cls] : "?";
+}
+
+int profile_write_csv(gb_instance *gb, FILE *out) {
+    const profile_data *p = &gb->profile;
+
+    fprintf(out, "opcode,handler,class,count,cycles,est_host_ns\n");
+    for (uint16_t key = 0; key < PROFILE_OPCODES; key++) {
+        if (p->count[key] == 0) {
+            continue;
+        }
+
+        profile_class cls = profile_class_of(key);
+        uint64_t ns = p->class_samples[cls] ? p->class_ns[cls] * p->count[key] / p->class_samples[cls] : 0;
+        fprintf(out, key >= 0x100 ? "0xCB%02X," : "0x%02X,", key & 0xFF);
+        fprintf(out, "%s,%s,%llu,%llu,%llu\n", instruction_names[key], class_names[cls],
+                (unsigned long long)p->count[key], (unsigned long long)p->cycles[key], (unsigned long long)ns);
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "sched.h"
+#include "gb.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static inline bool sched_before(scheduler *s, uint8_t a, uint8_t b) {
+    return s->when[a] < s->when[b];
+}
+
+static inline void sched_place(scheduler *s, uint8_t index, uint8_t event) {
+    s->heap[index] = event;
+    s->pos[event] = (int8_t)index;
+}
+
+static void sched_up(scheduler *s, uint8_t index) {
+    uint8_t event = s->heap[index];
+
+    while (index > 0) {
+        uint8_t parent = (index - 1) / 2;
+        if (!sched_before(s, event, s->heap[parent])) {
+            break;
+        }
+        sched_place(s, index, s->heap[parent]);
+        index = parent;
+    }
+
+    sched_place(s, index, event);
+}
+
+static void sched_down(scheduler *s, uint8_t index) {
+    uint8_t event = s->heap[index];
+
+    for (;;) {
+        uint8_t child = index * 2 + 1;
+        if (child >= s->size) {
+            break;
+        }
+        if (child + 1 < s->size && sched_before(s, s->heap[child + 1], s->heap[child])) {
+            child++;
+        }
+        if (!sched_before(s, s->heap[child], event)) {
+            break;
+        }
+        sched_place(s, index, s->heap[child]);
+        index = child;
+    }
+
+    sched_place(s, index, event);
+}
+
+// an event scheduled from inside an instruction also has to stop the running engine in time
+static inline void sched_update_next(gb_instance *gb) {
+    gb->next_event = gb->sched.size ? gb->sched.when[gb->sched.heap[0]] : UINT64_MAX;
+
+    if (gb->next_event < gb->run_deadline) {
+        gb->run_deadline = gb->next_event;
+    }
+}
+
+void sched_init(gb_instance *gb) {
+    memset(&gb->sched, 0, sizeof(scheduler));
+    memset(gb->sched.pos, -1, sizeof(gb->sched.pos));
+    gb->next_event = UINT64_MAX;
+}
+
+void sched_set_handler(gb_instance *gb, sched_event event, sched_callback handler) {
+    gb->sched.handler[event] = handler;
+}
+
+// schedules the event, or moves it if it is already pending
+void sched_add(gb_instance *gb, sched_event event, uint64_t when) {
+    scheduler *s = &gb->sched;
+
+    if (s->pos[event] < 0) {
+        s->when[event] = when;
+        sched_place(s, s->size++, (uint8_t)event);
+        sched_up(s, (uint8_t)s->pos[event]);
+    } else {
+        uint64_t old = s->when[event];
+        s->when[event] = when;
+        if (when < old) {
+            sched_up(s, (uint8_t)s->pos[event]);
+        } else {
+            sched_down(s, (uint8_t)s->pos[event]);
+        }
+    }
+
+    sched_update_next(gb);
+}
+
+void sched_cancel(gb_instance *gb, sched_event event) {
+    scheduler *s = &gb->sched;
+    int8_t index = s->pos[event];
+
+    if (index < 0) {
+        return ;
+    }
+
+    s->pos[event] = -1;
+    uint8_t last = s->heap[--s->size];
+    if (index < s->size) {
+        sched_place(s, (uint8_t)index, last);
+        sched_up(s, (uint8_t)index);
+        sched_down(s, (uint8_t)s->pos[last]);
+    }
+
+    sched_update_next(gb);
+}
+
+// fire every event that is due, in deadline order; handlers may schedule again
+void sched_run(gb_instance *gb) {
+    scheduler *s = &gb->sched;
+
+    while (s->size > 0 && s->when[s->heap[0]] <= gb->cpu.cycles) {
+        uint8_t event = s->heap[0];
+        uint64_t when = s->when[event];
+
+        sched_cancel(gb, (sched_event)event);
+        if (s->handler[event] != NULL) {
+            s->handler[event](gb, when);
+        }
+    }
+}
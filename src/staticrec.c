@@ -0,0 +1,43 @@
+#include "staticrec.h"
+#include "gb.h"
+#include "cart.h"
+#include "instructions.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+int staticrec_attach(gb_instance *gb, const staticrec_image *image) {
+    if (image != NULL) {
+        cart_header *header = (cart_header *)(gb->cart.rom_data + 0x0100);
+        uint16_t checksum = (uint16_t)(header->global_checksum[0] << 8 | header->global_checksum[1]);
+
+        if (gb->cart.rom_size < 0x0150 || checksum != image->global_checksum) {
+            printf("staticrec image does not match the cartridge\n");
+            return 1;
+        }
+    }
+
+    gb->rec = image;
+    return 0;
+}
+
+void staticrec_run(gb_instance *gb) {
+    const staticrec_image *image = gb->rec;
+
+    while (gb->cpu.cycles < gb->run_deadline && !gb->cpu.halted) {
+        uint16_t pc = gb->cpu.reg.pc;
+        const staticrec_block *block = NULL;
+
+        if (pc <= 0x3FFF || (pc <= 0x7FFF && gb->cart.rom_bank == image->rom_bank)) {
+            block = &image->blocks[pc];
+        }
+
+        // code the walker never reached (RAM, computed jumps, other banks) is interpreted,
+        // and so is a block that could run past run_deadline
+        if (block != NULL && block->run != NULL && gb->cpu.cycles + block->cycles <= gb->run_deadline) {
+            block->run(gb);
+        } else {
+            instructions_step(gb);
+        }
+    }
+}
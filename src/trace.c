@@ -0,0 +1,161 @@
+#include "trace.h"
+#include "gb.h"
+
+#if GB_TRACE_LEVEL > TRACE_LEVEL_OFF
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_MASK (GB_TRACE_RECORDS - 1)
+
+static const char *const kind_names[] = {"instr", "irq"};
+
+void trace_set_level(gb_instance *gb, uint8_t level) {
+    gb->trace.level = level < GB_TRACE_LEVEL ? level : GB_TRACE_LEVEL;
+}
+
+void trace_write(gb_instance *gb, trace_kind kind, uint16_t pc, uint8_t opcode, uint16_t arg) {
+    trace_buffer *t = &gb->trace;
+    trace_record *r = &t->ring[t->head & TRACE_MASK];
+
+    r->cycles = gb->cpu.cycles;
+    r->pc = pc;
+    r->sp = gb->cpu.reg.sp;
+    r->af = get_AF(&gb->cpu);
+    r->bc = gb->cpu.reg.bc;
+    r->de = gb->cpu.reg.de;
+    r->hl = gb->cpu.reg.hl;
+    r->arg = arg;
+    r->kind = (uint8_t)kind;
+    r->opcode = opcode;
+
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&t->head, t->head + 1, __ATOMIC_RELEASE);
+#else
+    t->head++;
+#endif
+}
+
+void trace_clear(gb_instance *gb) {
+    gb->trace.head = 0;
+}
+
+// the oldest record still in the ring, and how many follow it
+static uint64_t trace_first(uint64_t head, uint32_t *count) {
+    uint64_t first = head > GB_TRACE_RECORDS ? head - GB_TRACE_RECORDS : 0;
+    *count = (uint32_t)(head - first);
+    return first;
+}
+
+uint32_t trace_snapshot(gb_instance *gb, trace_record *out, uint32_t max) {
+    trace_buffer *t = &gb->trace;
+    uint32_t count;
+    uint64_t first = trace_first(t->head, &count);
+
+    if (count > max) {
+        first += count - max;
+        count = max;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = t->ring[(first + i) & TRACE_MASK];
+    }
+    return count;
+}
+
+int trace_dump(gb_instance *gb, FILE *out) {
+    trace_buffer *t = &gb->trace;
+    uint32_t count;
+    uint64_t first = trace_first(t->head, &count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const trace_record *r = &t->ring[(first + i) & TRACE_MASK];
+        fprintf(out, "%12llu %-5s pc=%04X op=%02X arg=%04X af=%04X bc=%04X de=%04X hl=%04X sp=%04X\n",
+                (unsigned long long)r->cycles, kind_names[r->kind], r->pc, r->opcode, r->arg,
+                r->af, r->bc, r->de, r->hl, r->sp);
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+int trace_dump_fd(gb_instance *gb, int fd) {
+    trace_buffer *t = &gb->trace;
+    uint32_t count;
+    uint64_t first = trace_first(t->head, &count);
+    uint32_t start = (uint32_t)(first & TRACE_MASK);
+    uint32_t tail = GB_TRACE_RECORDS - start < count ? GB_TRACE_RECORDS - start : count;
+
+    // the ring wraps at most once, so it goes out in two pieces
+    if (write(fd, &t->ring[start], tail * sizeof(trace_record)) < 0) {
+        return -1;
+    }
+    if (count > tail && write(fd, &t->ring[0], (count - tail) * sizeof(trace_record)) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    gb_instance *volatile gb; // NULL when the slot is free, set after path
+    char path[4096];
+} trace_crash_slot;
+
+static trace_crash_slot crash_slots[TRACE_CRASH_SLOTS];
+
+// open(2) is async-signal-safe, so a file is only created once there is something to dump
+static void trace_on_crash(int sig) {
+    for (int i = 0; i < TRACE_CRASH_SLOTS; i++) {
+        gb_instance *gb = crash_slots[i].gb;
+        if (gb == NULL) {
+            continue;
+        }
+
+        int fd = open(crash_slots[i].path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            trace_dump_fd(gb, fd);
+            close(fd);
+        }
+    }
+
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+int trace_install_crash_handler(gb_instance *gb, const char *path) {
+    static const int signals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+    trace_crash_slot *slot = NULL;
+
+    if (strlen(path) >= sizeof(slot->path)) {
+        return -1;
+    }
+
+    // a second install for the same instance only moves its file
+    trace_remove_crash_handler(gb);
+    for (int i = 0; i < TRACE_CRASH_SLOTS && slot == NULL; i++) {
+        if (crash_slots[i].gb == NULL) {
+            slot = &crash_slots[i];
+        }
+    }
+    if (slot == NULL) {
+        return -1;
+    }
+
+    strcpy(slot->path, path);
+    slot->gb = gb;
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+        signal(signals[i], trace_on_crash);
+    }
+    return 0;
+}
+
+void trace_remove_crash_handler(gb_instance *gb) {
+    for (int i = 0; i < TRACE_CRASH_SLOTS; i++) {
+        if (crash_slots[i].gb == gb) {
+            crash_slots[i].gb = NULL;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,63 @@
+#include "test.h"
+
+static void hdma_setup(gb_instance *gb, uint16_t source, uint16_t dest) {
+    bus_write(gb, 0xFF51, (uint8_t)(source >> 8));
+    bus_write(gb, 0xFF52, (uint8_t)source);
+    bus_write(gb, 0xFF53, (uint8_t)(dest >> 8));
+    bus_write(gb, 0xFF54, (uint8_t)dest);
+}
+
+static void test_hdma(gb_accuracy accuracy) {
+    static const uint8_t prog[] = {0x18, 0xFE}; // JR -2
+    static uint8_t rom[0x8000];
+
+    test_rom_init(rom, prog, sizeof(prog));
+    rom[0x0143] = 0xC0; // CGB only
+    for (int i = 0; i < 0x100; i++) {
+        rom[0x2000 + i] = (uint8_t)(0x40 + i);
+    }
+    gb_instance *gb = gb_create_rom(rom, sizeof(rom));
+    gb_set_accuracy(gb, accuracy);
+    for (int i = 0; i < 0x100; i++) {
+        gb->bus.wram[0][i] = (uint8_t)i;
+    }
+    CHECK_EQ(bus_read(gb, 0xFF55), 0xFF);
+
+    // general purpose: C000 -> 8100, 4 blocks, the CPU stalls 8 M-cycles per block
+    hdma_setup(gb, 0xC000, 0x8100);
+    uint64_t start = gb->cpu.cycles;
+    bus_write(gb, 0xFF55, 0x03);
+    CHECK_EQ(gb->cpu.cycles - start, 32);
+    CHECK_EQ(gb->bus.vram[0][0x100], 0x00);
+    CHECK_EQ(gb->bus.vram[0][0x13F], 0x3F);
+    CHECK_EQ(gb->bus.vram[0][0x140], 0x00);
+    CHECK_EQ(bus_read(gb, 0xFF55), 0xFF);
+
+    // HBlank: 2000 -> 9000, 3 blocks from the top of a frame, one per line
+    gb_run_cycles(gb, GB_CYCLES_PER_FRAME - gb->cpu.cycles % GB_CYCLES_PER_FRAME);
+    hdma_setup(gb, 0x2000, 0x9000);
+    bus_write(gb, 0xFF55, 0x82);
+    CHECK_EQ(bus_read(gb, 0xFF55), 0x02);
+    for (int line = 1; line <= 3; line++) {
+        gb_run_cycles(gb, 114);
+        CHECK_EQ(bus_read(gb, 0xFF55), line == 3 ? 0xFF : 2 - line);
+        for (int block = 0; block < 4; block++) {
+            CHECK_EQ(gb->bus.vram[0][0x1000 + 16 * block], block < line ? 0x40 + 16 * block : 0x00);
+        }
+    }
+
+    // writing bit 7 clear cancels an HBlank transfer, bit 7 then reads back set
+    bus_write(gb, 0xFF55, 0x85);
+    gb_run_cycles(gb, 114);
+    bus_write(gb, 0xFF55, 0x00);
+    CHECK_EQ(bus_read(gb, 0xFF55), 0x84);
+    CHECK_EQ(gb->hdma.active, 0);
+    gb_destroy(gb);
+}
+
+int main(void) {
+    for (int accuracy = GB_ACCURACY_FAST; accuracy <= GB_ACCURACY_PRECISE; accuracy++) {
+        test_hdma((gb_accuracy)accuracy);
+    }
+    return test_failures;
+}
@@ -0,0 +1,40 @@
+#include "test.h"
+
+int main(void) {
+    static const uint8_t handler[] = {0x51, 0x04, 0xD9}; // LD D,C; INC B; RETI
+    static const uint8_t prog[] = {
+        0x31, 0xFE, 0xFF, 0x06, 0x00, 0x0E, 0x00, 0x1E, 0x00, // LD SP,FFFE; B = C = E = 0
+        0x3E, 0x04, 0xEA, 0xFF, 0xFF, 0xE0, 0x0F,             // IE = IF = timer
+        0xFB, 0x0C, 0x0C,                                     // EI; INC C; INC C
+        0xF3, 0x3E, 0x04, 0xE0, 0x0F, 0xFB, 0xF3, 0x00,       // DI; IF = timer; EI; DI; NOP
+        0x76, 0x1C,                                           // HALT with IME off; INC E
+        0x18, 0xFE,                                           // JR -2
+    };
+    static uint8_t rom[0x8000];
+
+    test_rom_init(rom, prog, sizeof(prog));
+    memcpy(rom + 0x0050, handler, sizeof(handler));
+    for (int accuracy = GB_ACCURACY_FAST; accuracy <= GB_ACCURACY_PRECISE; accuracy++) {
+        for (int mode = JIT_OFF; mode <= JIT_VERIFY; mode++) {
+            gb_instance *gb = gb_create_rom(rom, sizeof(rom));
+            gb_set_accuracy(gb, (gb_accuracy)accuracy);
+            if (jit_set_mode(gb, (jit_mode)mode) != 0) {
+                gb_destroy(gb);
+                continue;
+            }
+            gb_run_frame(gb);
+
+            // the interrupt is taken once, after the instruction following EI
+            CHECK_EQ(gb->cpu.reg.b, 1);
+            CHECK_EQ(gb->cpu.reg.d, 1);
+            CHECK_EQ(gb->cpu.reg.c, 2);
+            // EI; DI never opens the window, HALT falls through and INC E runs twice
+            CHECK_EQ(gb->cpu.reg.e, 2);
+            CHECK_EQ(bus_read(gb, 0xFF0F) & 0x1F, 0x04);
+            CHECK_EQ(gb->irq.ime, 0);
+            CHECK_EQ(gb->cpu.reg.pc, 0x016D);
+            gb_destroy(gb);
+        }
+    }
+    return test_failures;
+}
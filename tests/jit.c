@@ -0,0 +1,101 @@
+#include "test.h"
+
+static uint8_t rom[0x8000];
+
+static gb_instance *run(jit_mode mode, uint32_t cycles) {
+    gb_instance *gb = gb_create_rom(rom, sizeof(rom));
+
+    if (jit_set_mode(gb, mode) != 0) {
+        gb_destroy(gb);
+        return NULL;
+    }
+    gb_run_cycles(gb, cycles);
+    return gb;
+}
+
+static void check_same(gb_instance *a, gb_instance *b) {
+    CHECK_EQ(b->cpu.reg.pc, a->cpu.reg.pc);
+    CHECK_EQ(b->cpu.reg.sp, a->cpu.reg.sp);
+    CHECK_EQ(b->cpu.reg.a, a->cpu.reg.a);
+    CHECK_EQ(flags_pack(&b->cpu), flags_pack(&a->cpu));
+    CHECK_EQ(b->cpu.reg.bc, a->cpu.reg.bc);
+    CHECK_EQ(b->cpu.reg.de, a->cpu.reg.de);
+    CHECK_EQ(b->cpu.reg.hl, a->cpu.reg.hl);
+    CHECK_EQ(b->cpu.cycles, a->cpu.cycles);
+    CHECK_EQ(memcmp(&b->bus, &a->bus, sizeof(emu_bus)), 0);
+    CHECK_EQ(bus_read(b, 0xFF06), bus_read(a, 0xFF06));
+}
+
+// runs the program in rom natively and on the interpreter, then once more in verify mode
+static void check_program(uint32_t cycles) {
+    gb_instance *interp = run(JIT_OFF, cycles);
+    gb_instance *native = run(JIT_ON, cycles);
+    gb_instance *verify = run(JIT_VERIFY, cycles);
+
+    if (native != NULL) {
+        check_same(interp, native);
+        CHECK_EQ(jit_get_stats(native)->blocks_compiled > 0, 1);
+        gb_destroy(native);
+    }
+    if (verify != NULL) {
+        check_same(interp, verify);
+        CHECK_EQ(jit_get_stats(verify)->verified > 0, 1);
+        CHECK_EQ(jit_get_stats(verify)->mismatches, 0);
+        gb_destroy(verify);
+    }
+    gb_destroy(interp);
+}
+
+int main(void) {
+    // fills C100-C7FF through a subroutine with branches, CB ops and the stack
+    static const uint8_t loop[] = {
+        0x31, 0xFF, 0xDF, 0x21, 0x00, 0xC1, 0x01, 0x00, 0x00, // LD SP,DFFF; LD HL,C100; LD BC,0
+        0x78, 0xCD, 0x70, 0x01, 0x22, 0x04,                   // 0159: LD A,B; CALL 0170; LD (HL+),A; INC B
+        0x7C, 0xFE, 0xC8, 0x20, 0xF5,                         // LD A,H; CP C8; JR NZ,0159
+        0x21, 0x00, 0xC1, 0x0C, 0x18, 0xEF,                   // LD HL,C100; INC C; JR 0159
+    };
+    static const uint8_t sub[] = {
+        0xC5, 0xCB, 0x37, 0x81, 0xCB, 0x19, 0x30, 0x01, 0x3C, // PUSH BC; SWAP A; ADD A,C; RR C; JR NC,+1; INC A
+        0xA8, 0xC1, 0xC9,                                     // XOR B; POP BC; RET
+    };
+    // read-modify-write on TMA, the verify replay must not apply it twice
+    static const uint8_t io[] = {
+        0x21, 0x06, 0xFF, 0x34, 0x34, 0x00, 0x18, 0xFA, // LD HL,FF06; INC (HL); INC (HL); NOP; JR -6
+    };
+    // writes INC A; RET to C000 and calls it, then patches it to INC B and calls it again
+    static const uint8_t smc[] = {
+        0x21, 0x00, 0xC0, 0x36, 0x3C, 0x23, 0x36, 0xC9, 0xCD, 0x00, 0xC0, // LD HL,C000; LD (HL),3C; INC HL; LD (HL),C9; CALL C000
+        0x21, 0x00, 0xC0, 0x36, 0x04, 0xCD, 0x00, 0xC0,                   // LD HL,C000; LD (HL),04; CALL C000
+        0x18, 0xFE,                                                       // JR -2
+    };
+
+    test_rom_init(rom, loop, sizeof(loop));
+    memcpy(rom + 0x0170, sub, sizeof(sub));
+    check_program(200000);
+
+    test_rom_init(rom, io, sizeof(io));
+    check_program(1000);
+
+    test_rom_init(rom, smc, sizeof(smc));
+    check_program(1000);
+    gb_instance *gb = run(JIT_ON, 1000);
+    if (gb != NULL) {
+        CHECK_EQ(gb->cpu.reg.a, 0x02);
+        CHECK_EQ(gb->cpu.reg.b, 0x01);
+        gb_destroy(gb);
+    }
+
+    // a block never runs past the requested budget by more than its last instruction
+    test_rom_init(rom, loop, sizeof(loop));
+    memcpy(rom + 0x0170, sub, sizeof(sub));
+    gb = run(JIT_ON, 10000);
+    if (gb != NULL) {
+        for (int i = 0; i < 1000; i++) {
+            uint64_t deadline = gb->cpu.cycles + 7 + i % 13;
+            gb_run_cycles(gb, 7 + i % 13);
+            CHECK_EQ(gb->cpu.cycles - deadline <= 6, 1);
+        }
+        gb_destroy(gb);
+    }
+    return test_failures;
+}
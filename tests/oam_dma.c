@@ -0,0 +1,105 @@
+#include "test.h"
+
+// copies C000-C09F into OAM from an HRAM routine, reading the source and OAM during and after the transfer
+static void test_hram_routine(gb_accuracy accuracy) {
+    static const uint8_t prog[] = {
+        0x3E, 0xC0, 0xE0, 0x46,       // LD A,C0; LDH (46),A
+        0xFA, 0x05, 0xC0, 0x47,       // LD A,(C005); LD B,A
+        0xFA, 0x05, 0xFE, 0x4F,       // LD A,(FE05); LD C,A
+        0x1E, 0x40, 0x1D, 0x20, 0xFD, // LD E,40; DEC E; JR NZ,-3
+        0xFA, 0x05, 0xC0, 0x57,       // LD A,(C005); LD D,A
+        0xFA, 0x05, 0xFE, 0x67,       // LD A,(FE05); LD H,A
+        0x18, 0xFE,                   // JR -2
+    };
+    static const uint8_t jump[] = {0xC3, 0x80, 0xFF}; // JP FF80
+    static uint8_t rom[0x8000];
+
+    test_rom_init(rom, jump, sizeof(jump));
+    gb_instance *gb = gb_create_rom(rom, sizeof(rom));
+    gb_set_accuracy(gb, accuracy);
+    for (int i = 0; i < 160; i++) {
+        gb->bus.wram[0][i] = (uint8_t)(0x80 + i);
+    }
+    memcpy(gb->bus.hram, prog, sizeof(prog));
+    gb_run_cycles(gb, 600);
+
+    if (accuracy == GB_ACCURACY_PRECISE) {
+        // the bus returns the byte being copied, OAM reads as FF
+        CHECK_EQ(gb->cpu.reg.b, 0x83);
+        CHECK_EQ(gb->cpu.reg.c, 0xFF);
+    } else {
+        CHECK_EQ(gb->cpu.reg.b, 0x85);
+        CHECK_EQ(gb->cpu.reg.c, 0x85);
+    }
+    CHECK_EQ(gb->cpu.reg.d, 0x85);
+    CHECK_EQ(gb->cpu.reg.h, 0x85);
+    CHECK_EQ(gb->bus.oam[0], 0x80);
+    CHECK_EQ(gb->bus.oam[159], 0x1F);
+    CHECK_EQ(gb->oam_dma.active, 0);
+    CHECK_EQ(gb->map.read[0xC0] == gb->bus.wram[0], 1);
+    gb_destroy(gb);
+}
+
+// with the source in WRAM, precise ROM opcode fetches see the copied byte: 3C runs as INC A
+static void test_rom_fetch(gb_accuracy accuracy) {
+    static const uint8_t prog[] = {0x3E, 0xC0, 0xE0, 0x46}; // LD A,C0; LDH (46),A; then NOPs
+    static const uint8_t tail[] = {0x47, 0x18, 0xFE};       // LD B,A; JR -2
+    static uint8_t rom[0x8000];
+
+    test_rom_init(rom, prog, sizeof(prog));
+    memcpy(rom + 0x0150 + sizeof(prog) + 200, tail, sizeof(tail));
+    gb_instance *gb = gb_create_rom(rom, sizeof(rom));
+    gb_set_accuracy(gb, accuracy);
+    memset(gb->bus.wram[0], 0x3C, 160);
+    gb_run_cycles(gb, 400);
+
+    CHECK_EQ(gb->cpu.reg.b, accuracy == GB_ACCURACY_PRECISE ? 0x5F : 0xC0);
+    CHECK_EQ(gb->bus.oam[0], 0x3C);
+    gb_destroy(gb);
+}
+
+// VBK during a WRAM-source transfer and SVBK during a VRAM-source one remap the window right away
+static void test_bank_switch(gb_accuracy accuracy) {
+    static const uint8_t prog[] = {
+        0x3E, 0xC0, 0xE0, 0x46,       // LD A,C0; LDH (46),A
+        0x3E, 0x01, 0xE0, 0x4F,       // VBK = 1
+        0xFA, 0x00, 0x80, 0x47,       // LD A,(8000); LD B,A
+        0x3E, 0x22, 0xEA, 0x01, 0x80, // LD A,22; LD (8001),A
+        0x1E, 0x40, 0x1D, 0x20, 0xFD, // LD E,40; DEC E; JR NZ,-3
+        0x3E, 0x80, 0xE0, 0x46,       // LD A,80; LDH (46),A
+        0x3E, 0x02, 0xE0, 0x70,       // SVBK = 2
+        0xFA, 0x00, 0xD0, 0x4F,       // LD A,(D000); LD C,A
+        0x3E, 0x44, 0xEA, 0x01, 0xD0, // LD A,44; LD (D001),A
+        0x1E, 0x40, 0x1D, 0x20, 0xFD, // LD E,40; DEC E; JR NZ,-3
+        0x18, 0xFE,                   // JR -2
+    };
+    static const uint8_t jump[] = {0xC3, 0x80, 0xFF}; // JP FF80
+    static uint8_t rom[0x8000];
+
+    test_rom_init(rom, jump, sizeof(jump));
+    rom[0x0143] = 0xC0; // CGB only
+    gb_instance *gb = gb_create_rom(rom, sizeof(rom));
+    gb_set_accuracy(gb, accuracy);
+    gb->bus.vram[1][0] = 0x11;
+    gb->bus.wram[2][0] = 0x33;
+    memcpy(gb->bus.hram, prog, sizeof(prog));
+    gb_run_cycles(gb, 1000);
+
+    CHECK_EQ(gb->cpu.reg.b, 0x11);
+    CHECK_EQ(gb->bus.vram[1][1], 0x22);
+    CHECK_EQ(gb->bus.vram[0][1], 0x00);
+    CHECK_EQ(gb->cpu.reg.c, 0x33);
+    CHECK_EQ(gb->bus.wram[2][1], 0x44);
+    CHECK_EQ(gb->bus.wram[1][1], 0x00);
+    CHECK_EQ(gb->oam_dma.active, 0);
+    gb_destroy(gb);
+}
+
+int main(void) {
+    for (int accuracy = GB_ACCURACY_FAST; accuracy <= GB_ACCURACY_PRECISE; accuracy++) {
+        test_hram_routine((gb_accuracy)accuracy);
+        test_rom_fetch((gb_accuracy)accuracy);
+        test_bank_switch((gb_accuracy)accuracy);
+    }
+    return test_failures;
+}
@@ -0,0 +1,50 @@
+#include "test.h"
+
+static uint64_t fired[16];
+static int fired_count;
+
+static void on_timer(gb_instance *gb, uint64_t when) {
+    fired[fired_count++] = when;
+    CHECK_EQ(gb->cpu.cycles >= when, 1);
+    if (when < 500) {
+        sched_add(gb, SCHED_TIMER, when + 100);
+    }
+}
+
+static void on_event(gb_instance *gb, uint64_t when) {
+    fired[fired_count++] = when;
+    CHECK_EQ(gb->cpu.cycles >= when, 1);
+}
+
+int main(void) {
+    static const uint8_t prog[] = {0x18, 0xFE}; // JR -2
+    static const uint64_t expected[] = {50, 100, 200, 250, 300, 320, 400, 500};
+    static uint8_t rom[0x8000];
+
+    test_rom_init(rom, prog, sizeof(prog));
+    gb_instance *gb = gb_create_rom(rom, sizeof(rom));
+    for (int event = 0; event < SCHED_EVENT_COUNT; event++) {
+        sched_set_handler(gb, (sched_event)event, event == SCHED_TIMER ? on_timer : on_event);
+    }
+
+    // a handler rescheduling itself, a cancelled event and two moved deadlines
+    sched_add(gb, SCHED_TIMER, 100);
+    sched_add(gb, SCHED_PPU, 250);
+    sched_add(gb, SCHED_APU, 50);
+    sched_add(gb, SCHED_SERIAL, 700);
+    sched_add(gb, SCHED_OAM_DMA, 10);
+    sched_cancel(gb, SCHED_OAM_DMA);
+    sched_add(gb, SCHED_HDMA, 900);
+    sched_add(gb, SCHED_HDMA, 320);
+    sched_add(gb, SCHED_SERIAL, 5000);
+    gb_run_cycles(gb, 1000);
+
+    CHECK_EQ(fired_count, sizeof(expected) / sizeof(expected[0]));
+    for (int i = 0; i < fired_count && i < (int)(sizeof(expected) / sizeof(expected[0])); i++) {
+        CHECK_EQ(fired[i], expected[i]);
+    }
+    CHECK_EQ(gb->next_event, 5000);
+
+    gb_destroy(gb);
+    return test_failures;
+}
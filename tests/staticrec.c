@@ -0,0 +1,78 @@
+#include "test.h"
+
+#include <stdlib.h>
+
+/**
+ * Built twice: with TEST_STATICREC_WRITE_ROM it only writes the test ROM to
+ * a file for gb_staticrec, otherwise it links the translation of that file
+ * and runs it against the interpreter.
+ */
+static uint8_t rom[0x8000];
+
+static void build_rom(void) {
+    static const uint8_t prog[] = {
+        0x31, 0xFF, 0xDF, 0x21, 0x00, 0xC0, // LD SP,DFFF; LD HL,C000
+        0x3E, 0x05, 0xE0, 0x07,             // TAC = 16 M-cycles
+        0x3E, 0x04, 0xE0, 0xFF, 0xFB,       // IE = timer; EI
+        0x04, 0x0C, 0x70, 0x2C,             // 015F: INC B; INC C; LD (HL),B; INC L
+        0x3E, 0x04, 0xE0, 0x0F,             // IF = timer, taken right after the store
+        0x14, 0x14, 0x1C, 0x1C, 0x1C, 0x1C, // INC D; INC D; INC E x4
+        0x18, 0xF0,                         // JR 015F
+    };
+    static const uint8_t handler[] = {0xF5, 0x7A, 0x22, 0xF1, 0xD9}; // PUSH AF; LD A,D; LD (HL+),A; POP AF; RETI
+
+    test_rom_init(rom, prog, sizeof(prog));
+    memcpy(rom + 0x0050, handler, sizeof(handler));
+}
+
+#ifdef TEST_STATICREC_WRITE_ROM
+
+int main(int argc, char *argv[]) {
+    FILE *out = argc == 2 ? fopen(argv[1], "wb") : NULL;
+
+    if (out == NULL) {
+        return 1;
+    }
+    build_rom();
+    int written = fwrite(rom, 1, sizeof(rom), out) == sizeof(rom);
+    return fclose(out) != 0 || !written;
+}
+
+#else
+
+extern const staticrec_image gb_staticrec_image;
+
+static void check_same(gb_instance *a, gb_instance *b) {
+    CHECK_EQ(b->cpu.reg.pc, a->cpu.reg.pc);
+    CHECK_EQ(b->cpu.reg.sp, a->cpu.reg.sp);
+    CHECK_EQ(b->cpu.reg.a, a->cpu.reg.a);
+    CHECK_EQ(flags_pack(&b->cpu), flags_pack(&a->cpu));
+    CHECK_EQ(b->cpu.reg.bc, a->cpu.reg.bc);
+    CHECK_EQ(b->cpu.reg.de, a->cpu.reg.de);
+    CHECK_EQ(b->cpu.reg.hl, a->cpu.reg.hl);
+    CHECK_EQ(b->cpu.cycles, a->cpu.cycles);
+    CHECK_EQ(memcmp(&b->bus, &a->bus, sizeof(emu_bus)), 0);
+}
+
+int main(void) {
+    build_rom();
+    gb_instance *interp = gb_create_rom(rom, sizeof(rom));
+    gb_instance *rec = gb_create_rom(rom, sizeof(rom));
+    CHECK_EQ(staticrec_attach(rec, &gb_staticrec_image), 0);
+
+    // short budgets end in the middle of blocks, timer interrupts arrive in the middle of others
+    for (int i = 0; i < 2000 && test_failures == 0; i++) {
+        gb_run_cycles(interp, 7 + i % 13);
+        gb_run_cycles(rec, 7 + i % 13);
+        check_same(interp, rec);
+    }
+    gb_run_frame(interp);
+    gb_run_frame(rec);
+    check_same(interp, rec);
+
+    gb_destroy(rec);
+    gb_destroy(interp);
+    return test_failures;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef __TEST_H
+#define __TEST_H
+
+#include <stdio.h>
+#include <string.h>
+#include "gb.h"
+
+/**
+ * Shared by the ctest programs. A failed CHECK_EQ prints the expression and
+ * both values and carries on, so one run reports every mismatch; main
+ * returns test_failures.
+ */
+static int test_failures;
+
+#define CHECK_EQ(actual, expected)                                              \
+    do {                                                                        \
+        long long actual_ = (long long)(actual);                                \
+        long long expected_ = (long long)(expected);                            \
+        if (actual_ != expected_) {                                             \
+            fprintf(stderr, "%s:%d: %s is %lld (0x%llx), expected %lld (0x%llx)\n", \
+                    __FILE__, __LINE__, #actual, actual_, actual_, expected_, expected_); \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+// a 32 KiB ROM-only image whose entry point jumps to prog at 0150
+static inline void test_rom_init(uint8_t *rom, const uint8_t *prog, size_t size) {
+    static const uint8_t entry[] = {0x00, 0xC3, 0x50, 0x01}; // NOP; JP 0150
+
+    memset(rom, 0, 0x8000);
+    memcpy(rom + 0x0100, entry, sizeof(entry));
+    memcpy(rom + 0x0150, prog, size);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+// gb_staticrec: translate the reachable code of a ROM into C for a specialized emulator build.
+// The output includes the interpreter's handlers, so every translated
+// instruction is the same code the interpreter runs, inlined with its
+// immediate operand as a constant.
+#define GB_HANDLERS_ONLY
+#include "instructions.c"
+#include "staticrec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STATICREC_BLOCK_LIMIT 256 // guest instructions per generated function
+
+#define NAME_ENTRY(code, func) [code] = #func,
+static const char *const op_names[256] = {
+    INSTRUCTION_LIST(NAME_ENTRY)
+};
+static const char *const cb_names[256] = {
+    CB_INSTRUCTION_LIST(NAME_ENTRY)
+};
+#undef NAME_ENTRY
+
+static uint8_t is_block[STATICREC_ADDR_SPACE];
+static uint16_t worklist[STATICREC_ADDR_SPACE];
+static uint32_t worklist_size;
+
+static void add_block(gb_instance *gb, uint16_t addr) {
+    if (addr >= STATICREC_ADDR_SPACE || addr >= gb->cart.rom_size || is_block[addr]) {
+        return ;
+    }
+
+    is_block[addr] = 1;
+    worklist[worklist_size++] = addr;
+}
+
+static uint16_t block_cycles[STATICREC_ADDR_SPACE];
+
+/**
+ * Walk one block from start, queueing every successor that is known without
+ * running the code and recording its worst case in block_cycles. With out
+ * set, also write the block's C function.
+ */
+static uint32_t walk_block(gb_instance *gb, uint16_t start, FILE *out) {
+    uint16_t addr = start;
+    uint32_t count = 0;
+    uint32_t cycles = 0;
+
+    if (out != NULL) {
+        fprintf(out, "static void rec_%04X(gb_instance *gb) {\n", start);
+    }
+
+    for (;;) {
+        decoded_instruction *entry = decode_fill(gb, addr, NULL);
+        uint16_t next = (uint16_t)(addr + entry->length);
+        uint16_t target = 0;
+        decode_flow flow = decode_flow_of(entry, addr, &target);
+        count++;
+        cycles += entry->cycles + decode_taken_cycles(entry->opcode);
+
+        if (out != NULL) {
+            fprintf(out, "    gb->cpu.reg.pc = 0x%04X;\n", next);
+            if (entry->opcode == 0xCB) {
+                fprintf(out, "    %s(gb);\n", cb_names[entry->operand & 0xFF]);
+            } else {
+                if (entry->length > 1) {
+                    fprintf(out, "    gb->cpu.imm = 0x%04X;\n", entry->operand);
+                }
+                fprintf(out, "    %s(gb);\n", op_names[entry->opcode]);
+            }
+            // an IE/IF store can raise an interrupt in the middle of the block
+            if (flow == FLOW_NEXT && decode_writes_memory(entry->opcode, (uint8_t)entry->operand)) {
+                fprintf(out, "    if (gb->cpu.cycles >= gb->run_deadline) {\n        return ;\n    }\n");
+            }
+        }
+
+        if (flow == FLOW_JUMP || flow == FLOW_CALL || flow == FLOW_BRANCH) {
+            add_block(gb, target);
+        }
+        if (flow == FLOW_CALL || flow == FLOW_BRANCH || flow == FLOW_RETURN_COND || flow == FLOW_STOP) {
+            add_block(gb, next);
+        }
+        if (flow != FLOW_NEXT) {
+            break;
+        }
+
+        // 0000-3FFF and 4000-7FFF are looked up separately, so no block spans both
+        if (next == 0x4000 || next >= STATICREC_ADDR_SPACE || next >= gb->cart.rom_size ||
+            count == STATICREC_BLOCK_LIMIT) {
+            add_block(gb, next);
+            break;
+        }
+
+        addr = next;
+    }
+
+    if (out != NULL) {
+        fprintf(out, "}\n\n");
+    }
+
+    block_cycles[start] = (uint16_t)cycles;
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        printf("usage: gb_staticrec <rom> <output.c>\n");
+        return 1;
+    }
+
+    gb_instance *gb = gb_create(argv[1]);
+    if (gb == NULL) {
+        return 1;
+    }
+
+    // cart_header.entry_point at 0100, then the RST and interrupt vectors
+    add_block(gb, 0x0100);
+    for (uint16_t vector = 0x00; vector <= 0x60; vector += 0x08) {
+        add_block(gb, vector);
+    }
+
+    uint32_t instructions = 0;
+    for (uint32_t i = 0; i < worklist_size; i++) {
+        instructions += walk_block(gb, worklist[i], NULL);
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL) {
+        printf("can not open %s\n", argv[2]);
+        gb_destroy(gb);
+        return 1;
+    }
+
+    cart_header *header = (cart_header *)(gb->cart.rom_data + 0x0100);
+    fprintf(out, "// generated by gb_staticrec from %s, do not edit\n", argv[1]);
+    fprintf(out, "#define GB_HANDLERS_ONLY\n#include \"instructions.c\"\n#include \"staticrec.h\"\n\n");
+
+    for (uint32_t addr = 0; addr < STATICREC_ADDR_SPACE; addr++) {
+        if (is_block[addr]) {
+            walk_block(gb, (uint16_t)addr, out);
+        }
+    }
+
+    fprintf(out, "static const staticrec_block rec_blocks[STATICREC_ADDR_SPACE] = {\n");
+    for (uint32_t addr = 0; addr < STATICREC_ADDR_SPACE; addr++) {
+        if (is_block[addr]) {
+            fprintf(out, "    [0x%04X] = {rec_%04X, %u},\n", addr, addr, block_cycles[addr]);
+        }
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "const staticrec_image gb_staticrec_image = {\n");
+    fprintf(out, "    .global_checksum = 0x%02X%02X,\n", header->global_checksum[0], header->global_checksum[1]);
+    fprintf(out, "    .rom_bank = %u,\n", gb->cart.rom_bank);
+    fprintf(out, "    .block_count = %u,\n", worklist_size);
+    fprintf(out, "    .blocks = rec_blocks,\n");
+    fprintf(out, "};\n");
+    fclose(out);
+
+    printf("%u blocks, %u instructions translated\n", worklist_size, instructions);
+    gb_destroy(gb);
+    return 0;
+}